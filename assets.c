@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "assets.h"
+#include "platform.h"
+
+static struct {
+    const unsigned char* data;     // Resident part of the archive
+    long size;
+    const PakEntry* entries;
+    int entryCount;
+    char path[128];
+} pak;
+
+// The packer has already checked every asset; this only makes sure the index
+// cannot send a lookup outside what was loaded
+static int checkIndex(const PakHeader* header) {
+    long indexEnd = sizeof(PakHeader) + (long)header->entryCount * sizeof(PakEntry);
+    if(indexEnd > header->residentBytes) return -1;
+
+    const PakEntry* entries = (const PakEntry*)(pak.data + sizeof(PakHeader));
+    for(unsigned int i = 0; i < header->entryCount; i++) {
+        const PakEntry* e = &entries[i];
+        if(memchr(e->name, '\0', PAK_NAME_LENGTH) == NULL) return -1;
+        if(e->type == PAK_VORBIS) {
+            if(e->offset < header->residentBytes) return -1;
+        } else if(e->offset < indexEnd || e->offset % PAK_ALIGN != 0 ||
+                  (long)e->offset + e->size > header->residentBytes) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int assetsOpen(const char* path) {
+    int fd = platformFileOpen(path);
+    if(fd < 0) return -1;
+
+    PakHeader header;
+    const unsigned char* data = NULL;
+    if(platformFileRead(fd, &header, sizeof(header)) == sizeof(header) &&
+       header.magic == PAK_MAGIC && header.version == PAK_VERSION &&
+       header.residentBytes >= sizeof(header) &&
+       platformFileSeek(fd, 0, SEEK_END) >= (long)header.residentBytes) {
+        data = (const unsigned char*)platformFileMap(fd, header.residentBytes);
+    }
+    platformFileClose(fd);
+    if(!data) return -1;
+
+    pak.data = data;
+    pak.size = header.residentBytes;
+    if(checkIndex(&header) < 0) {
+        platformFileUnmap(data, header.residentBytes);
+        memset(&pak, 0, sizeof(pak));
+        return -1;
+    }
+    pak.entries = (const PakEntry*)(data + sizeof(PakHeader));
+    pak.entryCount = header.entryCount;
+    snprintf(pak.path, sizeof(pak.path), "%s", path);
+    return 0;
+}
+
+const PakEntry* assetFind(const char* name, PakType type) {
+    for(int i = 0; i < pak.entryCount; i++) {
+        const PakEntry* e = &pak.entries[i];
+        if(e->type == (unsigned int)type && strcmp(e->name, name) == 0) return e;
+    }
+    return NULL;
+}
+
+const void* assetData(const PakEntry* entry) {
+    if(entry->offset >= pak.size) return NULL;
+    return pak.data + entry->offset;
+}
+
+const char* assetsPath(void) {
+    return pak.path;
+}
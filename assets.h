@@ -0,0 +1,66 @@
+// Asset archive: one file holding every asset the game loads, written by the
+// host packer (tools/pack_assets.c), which validates each asset on the way in.
+// A header and index come first, then the resident assets, then the streamed
+// ones. At startup the resident part is mapped (Linux) or read in one piece
+// (PSP), and assets are handed out as pointers into it with no copying.
+// Streamed assets stay on disk and are read through a FileStream
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "meshes.h"
+
+#define ASSETS_FILE "assets.pak"
+
+#define PAK_MAGIC 0x4B415050       // "PPAK", little-endian
+#define PAK_VERSION 2
+#define PAK_ALIGN 64               // Resident assets start on a cache line
+#define PAK_STREAM_ALIGN 2048      // Streamed assets start on a memory stick sector multiple
+#define PAK_NAME_LENGTH 24
+
+// Names the game looks assets up by
+#define ASSET_SHOOT "shoot"
+#define ASSET_MUSIC "music"
+#define ASSET_MESHES "meshes"
+
+typedef enum {
+    PAK_PCM = 1,        // Interleaved 16-bit stereo at AUDIO_SAMPLE_RATE; info is the frame count
+    PAK_VORBIS,         // Ogg Vorbis stream, 2 channels at AUDIO_SAMPLE_RATE. Streamed
+    PAK_MESHES          // A PakMeshTable
+} PakType;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int entryCount;
+    unsigned int residentBytes;    // Header, index and resident assets
+} PakHeader;
+
+typedef struct {
+    char name[PAK_NAME_LENGTH];
+    unsigned int type;
+    unsigned int offset;           // From the start of the file
+    unsigned int size;
+    unsigned int info;
+} PakEntry;
+
+// Baked meshes. The vertices follow at verticesOffset from the table's start,
+// 16-byte aligned, as PackedVertex
+typedef struct {
+    unsigned int meshCount;        // MESH_COUNT when baked
+    unsigned int vertexCount;
+    unsigned int verticesOffset;
+    float positionScale;           // What a packed position is a fraction of
+    MeshRange ranges[MESH_COUNT];
+} PakMeshTable;
+
+// Load the archive's index and resident assets. Returns < 0 if the file is
+// missing or its index does not check out
+int assetsOpen(const char* path);
+// The entry with this name and type, or NULL
+const PakEntry* assetFind(const char* name, PakType type);
+// A resident asset's bytes, or NULL for a streamed one
+const void* assetData(const PakEntry* entry);
+// The archive file, for streaming
+const char* assetsPath(void);
+
+#endif
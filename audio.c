@@ -0,0 +1,457 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <vorbis/vorbisfile.h>
+
+#include "audio.h"
+#include "mixer.h"
+#include "audio_queue.h"
+#include "file_stream.h"
+#include "assets.h"
+#include "platform.h"
+
+#define PAN_RANGE 4.0f   // World x that maps to fully left or right
+
+// Music is decoded ahead on its own thread into a ring the audio thread only
+// copies from, so a slow read or the loop seek never holds up an output block
+#define MUSIC_RING_FRAMES (AUDIO_MAX_BLOCK_SAMPLES * 8)   // A power of two, ~370 ms
+#define MUSIC_CHUNK_FRAMES 1024                           // Most decoded per ov_read
+#define MUSIC_LOOP_FRAMES (AUDIO_MAX_BLOCK_SAMPLES * 2)   // Track start kept decoded for the wrap
+#define DECODER_IDLE_US 10000
+
+typedef struct {
+    OggVorbis_File vf;
+    FileStream stream;
+    int playing;                // Set once the ring has been filled
+    int volume;                 // 0-10, owned by the audio thread
+
+    // Decoder thread. The first frames of the track stay decoded; looping
+    // copies them in and seeks past them, so the wrap has no gap
+    short loopHead[MUSIC_LOOP_FRAMES * 2];
+    int loopHeadFrames;
+    int loopHeadPos;            // Next loopHead frame to copy; == loopHeadFrames once done
+    unsigned int decodeErrors;
+
+    // Ring of stereo frames. Counters only grow: the decoder stores written,
+    // the audio thread stores read
+    short ring[MUSIC_RING_FRAMES * 2];
+    unsigned int written __attribute__((aligned(64)));
+    unsigned int read __attribute__((aligned(64)));
+
+    // Audio thread
+    unsigned int underruns;     // Blocks the ring could not fill
+    unsigned int missingFrames;
+    unsigned int minBuffered;   // Fewest frames buffered at the start of a block
+} Music;
+
+// Gain and priority per sound; a player hit must always be heard
+static const struct {
+    float gain;
+    int priority;
+} soundParams[SOUND_COUNT] = {
+    {1.0f, 1},   // SOUND_SHOOT
+    {0.7f, 2},   // SOUND_EXPLOSION
+    {0.9f, 3},   // SOUND_HIT
+};
+
+static Sample sounds[SOUND_COUNT];
+static int audioReady = 0;
+static AudioQueue commands;   // Game thread -> audio thread
+static Music bgMusic = {0};
+static volatile int audioRunning = 1;
+static int blockSamples = AUDIO_DEFAULT_BLOCK_SAMPLES;
+
+// Effect latency and audio thread load. The totals belong to the audio
+// thread; the published figures are what other threads read
+static struct {
+    int plays;                   // Effects started in the block being mixed
+    unsigned int waitSum;        // Their time in the queue before the block began
+    unsigned int waitMax;
+    unsigned long long latencySum;
+    unsigned long long busyUs;
+    unsigned int sounds;
+    unsigned int blocks;
+    unsigned int latencyAvgUs;
+    unsigned int latencyMaxUs;
+    unsigned int busyBasisPoints;
+} timing;
+
+// OGG Vorbis file I/O callbacks over a read-ahead stream: libvorbisfile asks
+// for a few KB at a time, which the stream serves from its chunk buffers
+static size_t ogg_read_func(void *ptr, size_t size, size_t nmemb, void *datasource) {
+    return fileStreamRead((FileStream*)datasource, ptr, size * nmemb);
+}
+
+static int ogg_seek_func(void *datasource, ogg_int64_t offset, int whence) {
+    return (fileStreamSeek((FileStream*)datasource, (long)offset, whence) >= 0) ? 0 : -1;
+}
+
+static int ogg_close_func(void *datasource) {
+    fileStreamClose((FileStream*)datasource);
+    return 0;
+}
+
+static long ogg_tell_func(void *datasource) {
+    return fileStreamTell((FileStream*)datasource);
+}
+
+static ov_callbacks oggCallbacks = {
+    ogg_read_func,
+    ogg_seek_func,
+    ogg_close_func,
+    ogg_tell_func
+};
+
+// Open the archive's Vorbis stream for streaming. The track start is
+// decoded here, once, and becomes the first thing in the ring
+int loadMusic(const char* name) {
+    const PakEntry* entry = assetFind(name, PAK_VORBIS);
+    if (!entry) return -1;
+    if (fileStreamOpen(&bgMusic.stream, assetsPath(), entry->offset, entry->size) < 0) return -1;
+
+    if (ov_open_callbacks(&bgMusic.stream, &bgMusic.vf, NULL, 0, oggCallbacks) < 0) {
+        fileStreamClose(&bgMusic.stream);
+        return -1;
+    }
+
+    int frames = 0, holes = 0, bitstream;
+    while (frames < MUSIC_LOOP_FRAMES) {
+        long bytes = ov_read(&bgMusic.vf, (char*)&bgMusic.loopHead[frames * 2],
+                             (MUSIC_LOOP_FRAMES - frames) * 4, 0, 2, 1, &bitstream);
+        if (bytes == 0) break;
+        if (bytes < 0) {
+            // A hole in the stream; decoding goes on after it unless it keeps failing
+            if (++holes > 8) break;
+            continue;
+        }
+        frames += bytes / 4;
+    }
+    if (frames == 0) {
+        ov_clear(&bgMusic.vf);
+        return -1;
+    }
+
+    bgMusic.loopHeadFrames = frames;
+    bgMusic.loopHeadPos = 0;
+    // The seek back to the end of the loop head lands about where its decode
+    // left the file, so that is the chunk to have waiting at the end
+    fileStreamLoop(&bgMusic.stream, fileStreamTell(&bgMusic.stream));
+    bgMusic.written = 0;
+    bgMusic.read = 0;
+    bgMusic.minBuffered = MUSIC_RING_FRAMES;
+    return 0;
+}
+
+// Fill the ring as far as it goes, from the loop head while that is being
+// replayed and from the decoder otherwise. Returns frames added
+static int decodeAhead(void) {
+    int added = 0;
+    int bitstream;
+
+    while (1) {
+        unsigned int written = bgMusic.written;
+        unsigned int read = __atomic_load_n(&bgMusic.read, __ATOMIC_ACQUIRE);
+        int space = MUSIC_RING_FRAMES - (int)(written - read);
+        int offset = written & (MUSIC_RING_FRAMES - 1);
+        int want = MUSIC_RING_FRAMES - offset;  // Up to the end of the ring
+        if (want > space) want = space;
+        if (want > MUSIC_CHUNK_FRAMES) want = MUSIC_CHUNK_FRAMES;
+        if (want <= 0) break;
+
+        short* dst = &bgMusic.ring[offset * 2];
+        int got;
+        if (bgMusic.loopHeadPos < bgMusic.loopHeadFrames) {
+            got = bgMusic.loopHeadFrames - bgMusic.loopHeadPos;
+            if (got > want) got = want;
+            memcpy(dst, &bgMusic.loopHead[bgMusic.loopHeadPos * 2], got * 4);
+            bgMusic.loopHeadPos += got;
+        } else {
+            long bytes = ov_read(&bgMusic.vf, (char*)dst, want * 4, 0, 2, 1, &bitstream);
+            if (bytes == 0) {
+                // End of the track: replay the decoded start and carry on
+                // decoding right after it
+                ov_pcm_seek(&bgMusic.vf, bgMusic.loopHeadFrames);
+                bgMusic.loopHeadPos = 0;
+                continue;
+            }
+            if (bytes < 0) {
+                bgMusic.decodeErrors++;
+                break;  // Try again on the next pass
+            }
+            got = bytes / 4;
+        }
+
+        __atomic_store_n(&bgMusic.written, written + got, __ATOMIC_RELEASE);
+        added += got;
+    }
+    return added;
+}
+
+// Decoder thread: keep the ring topped up. It runs below the audio thread and
+// sleeps between passes; the ring holds several blocks, so it can be late
+static int decoderThread(void* arg) {
+    while (audioRunning) {
+        decodeAhead();
+        platformSleepUs(DECODER_IDLE_US);
+    }
+    return 0;
+}
+
+// Copy decoded music out of the ring with volume scaling. Whatever the
+// decoder has not produced yet is silence and counts as an underrun
+int streamMusic(short* outBuffer, int samples) {
+    if (!__atomic_load_n(&bgMusic.playing, __ATOMIC_ACQUIRE)) {
+        memset(outBuffer, 0, samples * 4);
+        return 0;
+    }
+
+    unsigned int read = bgMusic.read;
+    unsigned int buffered = __atomic_load_n(&bgMusic.written, __ATOMIC_ACQUIRE) - read;
+    if (buffered < bgMusic.minBuffered) __atomic_store_n(&bgMusic.minBuffered, buffered, __ATOMIC_RELAXED);
+    int toCopy = (int)buffered < samples ? (int)buffered : samples;
+
+    // Volume: 0-10 maps to 0-32760 (PSP_AUDIO_VOLUME_MAX is 0x8000)
+    int volumeScale = bgMusic.volume * 3276;
+
+    for (int i = 0; i < toCopy; i++) {
+        const short* frame = &bgMusic.ring[((read + i) & (MUSIC_RING_FRAMES - 1)) * 2];
+        outBuffer[i * 2] = (short)((frame[0] * volumeScale) >> 15);
+        outBuffer[i * 2 + 1] = (short)((frame[1] * volumeScale) >> 15);
+    }
+    __atomic_store_n(&bgMusic.read, read + toCopy, __ATOMIC_RELEASE);
+
+    if (toCopy < samples) {
+        memset(&outBuffer[toCopy * 2], 0, (samples - toCopy) * 4);
+        __atomic_store_n(&bgMusic.underruns, bgMusic.underruns + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&bgMusic.missingFrames, bgMusic.missingFrames + (samples - toCopy), __ATOMIC_RELAXED);
+    }
+    return toCopy;
+}
+
+void audioStats(AudioStats* out) {
+    out->blockSamples = blockSamples;
+    out->blocks = __atomic_load_n(&timing.blocks, __ATOMIC_RELAXED);
+    out->sounds = __atomic_load_n(&timing.sounds, __ATOMIC_RELAXED);
+    out->latencyAvgUs = __atomic_load_n(&timing.latencyAvgUs, __ATOMIC_RELAXED);
+    out->latencyMaxUs = __atomic_load_n(&timing.latencyMaxUs, __ATOMIC_RELAXED);
+    out->busyBasisPoints = __atomic_load_n(&timing.busyBasisPoints, __ATOMIC_RELAXED);
+}
+
+// Ring health, for reports from other threads. Nothing until the music is
+// playing: until then the loader is still setting it up
+void musicStats(MusicStats* out) {
+    if (!__atomic_load_n(&bgMusic.playing, __ATOMIC_ACQUIRE)) {
+        memset(out, 0, sizeof(*out));
+        out->bufferFrames = MUSIC_RING_FRAMES;
+        return;
+    }
+    out->underruns = __atomic_load_n(&bgMusic.underruns, __ATOMIC_RELAXED);
+    out->missingFrames = __atomic_load_n(&bgMusic.missingFrames, __ATOMIC_RELAXED);
+    out->minBufferedFrames = __atomic_load_n(&bgMusic.minBuffered, __ATOMIC_RELAXED);
+    out->bufferFrames = MUSIC_RING_FRAMES;
+    fileStreamStats(&bgMusic.stream, &out->io);
+}
+
+// Everything the game thread asks of the audio thread goes through the
+// queue, so the two never touch the same voice or music state
+static void sendCommand(const AudioCommand* c) {
+    if (!audioReady) return;
+    audioQueuePush(&commands, c);
+}
+
+static float panFromX(float x) {
+    float pan = x / PAN_RANGE;
+    if (pan < -1.0f) pan = -1.0f;
+    if (pan > 1.0f) pan = 1.0f;
+    return pan;
+}
+
+// Note how long a started effect sat in the queue before this block began
+static void recordPlay(unsigned int now, unsigned int sent) {
+    int wait = (int)(now - sent);
+    if (wait < 0) wait = 0;   // Sent after the block began
+    timing.waitSum += wait;
+    if ((unsigned int)wait > timing.waitMax) timing.waitMax = wait;
+    timing.plays++;
+}
+
+// Apply the commands queued since the last block
+static void drainCommands(unsigned int now) {
+    AudioCommand c;
+    while (audioQueuePop(&commands, &c)) {
+        switch (c.type) {
+            case AUDIO_CMD_PLAY:
+                if (mixerPlay(&sounds[c.sound], c.gain, c.pan, c.priority) >= 0) recordPlay(now, c.timeUs);
+                break;
+            case AUDIO_CMD_STOP:
+                mixerStop(&sounds[c.sound]);
+                break;
+            case AUDIO_CMD_SET_VOLUME:
+                bgMusic.volume = c.value;
+                break;
+            case AUDIO_CMD_SET_PAN:
+                mixerSetPan(&sounds[c.sound], c.pan);
+                break;
+        }
+    }
+}
+
+// Set music volume (0-10)
+void setMusicVolume(int volume) {
+    if (volume < 0) volume = 0;
+    if (volume > 10) volume = 10;
+    AudioCommand c = {AUDIO_CMD_SET_VOLUME, 0, 0, volume, 0.0f, 0.0f};
+    sendCommand(&c);
+}
+
+// Point a sample at PCM in the asset archive. The packer has already checked
+// the format, so the mixer plays it in place
+static int loadSample(const char* name, Sample* sound) {
+    const PakEntry* entry = assetFind(name, PAK_PCM);
+    if (!entry) return -1;
+    sound->data = (const short*)assetData(entry);
+    sound->frames = entry->info;
+    return 0;
+}
+
+// Effects with no asset behind them are synthesised once at startup.
+// Explosion: low-passed noise whose cutoff and level fall away together
+static void makeExplosion(Sample* sound) {
+    int frames = AUDIO_SAMPLE_RATE * 45 / 100;
+    short* data = (short*)malloc(frames * 4);
+    if (!data) return;
+
+    unsigned int noise = 0x1234567u;
+    float level = 0.0f;
+    for (int i = 0; i < frames; i++) {
+        float t = (float)i / frames;
+        noise = noise * 1664525u + 1013904223u;
+        float white = (float)(int)(noise >> 16 & 0xFFFF) / 32768.0f - 1.0f;
+        level += (white - level) * (0.35f * (1.0f - t) + 0.02f);
+        float envelope = (1.0f - t) * (1.0f - t);
+        short v = (short)(level * envelope * 30000.0f);
+        data[i * 2] = v;
+        data[i * 2 + 1] = v;
+    }
+    sound->data = data;
+    sound->frames = frames;
+}
+
+// Hit: a square wave dropping an octave with a fast decay
+static void makeHit(Sample* sound) {
+    int frames = AUDIO_SAMPLE_RATE * 12 / 100;
+    short* data = (short*)malloc(frames * 4);
+    if (!data) return;
+
+    float phase = 0.0f;
+    for (int i = 0; i < frames; i++) {
+        float t = (float)i / frames;
+        phase += (440.0f - 220.0f * t) / AUDIO_SAMPLE_RATE;
+        if (phase >= 1.0f) phase -= 1.0f;
+        float envelope = expf(-5.0f * t);
+        short v = (short)((phase < 0.5f ? 1.0f : -1.0f) * envelope * 20000.0f);
+        data[i * 2] = v;
+        data[i * 2 + 1] = v;
+    }
+    sound->data = data;
+    sound->frames = frames;
+}
+
+// Account for one block about to be handed to the output. An effect is heard
+// once the block already queued on the channel has played, so its latency is
+// the wait until now plus one block
+static void recordBlock(unsigned int start, unsigned int submit) {
+    unsigned int blockUs = (unsigned int)(blockSamples * 1000000ull / AUDIO_SAMPLE_RATE);
+    timing.busyUs += submit - start;
+    __atomic_store_n(&timing.blocks, timing.blocks + 1, __ATOMIC_RELAXED);
+
+    if (timing.plays > 0) {
+        unsigned int after = submit - start + blockUs;
+        timing.latencySum += timing.waitSum + (unsigned long long)timing.plays * after;
+        __atomic_store_n(&timing.sounds, timing.sounds + timing.plays, __ATOMIC_RELAXED);
+        unsigned int worst = timing.waitMax + after;
+        if (worst > timing.latencyMaxUs) __atomic_store_n(&timing.latencyMaxUs, worst, __ATOMIC_RELAXED);
+        __atomic_store_n(&timing.latencyAvgUs, (unsigned int)(timing.latencySum / timing.sounds), __ATOMIC_RELAXED);
+        timing.plays = 0;
+        timing.waitSum = 0;
+        timing.waitMax = 0;
+    }
+    __atomic_store_n(&timing.busyBasisPoints,
+                     (unsigned int)(timing.busyUs * 10000 / ((unsigned long long)timing.blocks * blockUs)), __ATOMIC_RELAXED);
+}
+
+// Audio thread - mixes background music and sound effects
+static int audioThread(void* arg) {
+    static short music[AUDIO_MAX_BLOCK_SAMPLES * 2];
+    static short buffer[AUDIO_MAX_BLOCK_SAMPLES * 2];  // Final output buffer (stereo)
+
+    while (audioRunning) {
+        unsigned int start = (unsigned int)platformWallTimeUs();
+        drainCommands(start);
+
+        // Stream background music, then every playing effect on top of it
+        streamMusic(music, blockSamples);
+        mixerRender(buffer, music, blockSamples);
+
+        recordBlock(start, (unsigned int)platformWallTimeUs());
+        platformAudioOutput(buffer);
+    }
+    return 0;
+}
+
+// Initialize audio system with blocks of about the given size: rounded to a
+// multiple of 64 and kept within what the mixer and the PSP accept
+void initAudio(int blockSize) {
+    blockSize = (blockSize + 32) & ~63;
+    if (blockSize < AUDIO_MIN_BLOCK_SAMPLES) blockSize = AUDIO_MIN_BLOCK_SAMPLES;
+    if (blockSize > AUDIO_MAX_BLOCK_SAMPLES) blockSize = AUDIO_MAX_BLOCK_SAMPLES;
+    blockSamples = blockSize;
+    if (platformAudioOpen(blockSamples) < 0) return;
+
+    mixerInit();
+    audioQueueInit(&commands);
+    loadSample(ASSET_SHOOT, &sounds[SOUND_SHOOT]);
+    makeExplosion(&sounds[SOUND_EXPLOSION]);
+    makeHit(&sounds[SOUND_HIT]);
+    bgMusic.volume = 8;  // Default 80%
+
+    audioReady = 1;
+    platformStartThread("audio_thread", audioThread, NULL, THREAD_PRIORITY_AUDIO, 0x10000);
+}
+
+// Open the music and fill the ring, then let the audio thread play it. Effects
+// already work meanwhile, so this can run after the game has started
+void startMusic(void) {
+    if (!audioReady || loadMusic(ASSET_MUSIC) < 0) return;
+
+    // Start with a full ring so the first blocks never wait on the decoder
+    decodeAhead();
+    __atomic_store_n(&bgMusic.playing, 1, __ATOMIC_RELEASE);
+    platformStartThread("music_decoder", decoderThread, NULL, THREAD_PRIORITY_DECODER, 0x10000);
+}
+
+// Start a sound effect, panned by where it happened across the field
+void playSound(SoundId sound, float x) {
+    AudioCommand c = {AUDIO_CMD_PLAY, sound, soundParams[sound].priority, 0,
+                      soundParams[sound].gain, panFromX(x), (unsigned int)platformWallTimeUs()};
+    sendCommand(&c);
+}
+
+// Cut every voice playing a sound
+void stopSound(SoundId sound) {
+    AudioCommand c = {AUDIO_CMD_STOP, sound, 0, 0, 0.0f, 0.0f};
+    sendCommand(&c);
+}
+
+// Move every voice playing a sound to a new position across the field
+void setSoundPan(SoundId sound, float x) {
+    AudioCommand c = {AUDIO_CMD_SET_PAN, sound, 0, 0, 0.0f, panFromX(x)};
+    sendCommand(&c);
+}
+
+// Commands dropped because the audio thread fell a whole queue behind
+unsigned int audioCommandOverflows(void) {
+    return commands.overflows;
+}
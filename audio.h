@@ -0,0 +1,43 @@
+// Audio: Vorbis music decoded ahead on its own thread, with sound effects
+// mixed on top, fed to the platform's output channel from a dedicated thread
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include "file_stream.h"
+
+typedef enum {
+    SOUND_SHOOT,
+    SOUND_EXPLOSION,
+    SOUND_HIT,          // Player damaged
+    SOUND_COUNT
+} SoundId;
+
+typedef struct {
+    unsigned int underruns;          // Output blocks the music ring could not fill
+    unsigned int missingFrames;      // Frames of silence those left
+    unsigned int minBufferedFrames;  // Lowest the ring has been at the start of a block
+    unsigned int bufferFrames;       // Ring size
+    FileStreamStats io;              // Reads of the music file
+} MusicStats;
+
+// Effect latency and what the block size costs the audio thread
+typedef struct {
+    int blockSamples;
+    unsigned int blocks;            // Audio thread wakeups so far
+    unsigned int sounds;            // Effects started
+    unsigned int latencyAvgUs;      // Trigger to heard
+    unsigned int latencyMaxUs;
+    unsigned int busyBasisPoints;   // Audio thread busy time per audio played, in 0.01%
+} AudioStats;
+
+void initAudio(int blockSamples);
+void startMusic(void);
+void playSound(SoundId sound, float x);
+void stopSound(SoundId sound);
+void setSoundPan(SoundId sound, float x);
+unsigned int audioCommandOverflows(void);
+void musicStats(MusicStats* out);
+void audioStats(AudioStats* out);
+void setMusicVolume(int volume);
+
+#endif
@@ -0,0 +1,34 @@
+#include <string.h>
+
+#include "audio_queue.h"
+
+#define QUEUE_MASK (AUDIO_QUEUE_SIZE - 1)
+
+void audioQueueInit(AudioQueue* q) {
+    memset(q, 0, sizeof(*q));
+}
+
+// Each index only ever grows and is stored by one side. The release store of
+// head publishes the slot written before it; the acquire load on the other
+// side makes that slot visible before it is read. Same for tail, so a slot is
+// never overwritten while it is still being copied out
+int audioQueuePush(AudioQueue* q, const AudioCommand* command) {
+    unsigned int head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    unsigned int tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    if(head - tail >= AUDIO_QUEUE_SIZE) {
+        q->overflows++;
+        return -1;
+    }
+    q->slots[head & QUEUE_MASK] = *command;
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int audioQueuePop(AudioQueue* q, AudioCommand* command) {
+    unsigned int tail = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    unsigned int head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    if(head == tail) return 0;
+    *command = q->slots[tail & QUEUE_MASK];
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
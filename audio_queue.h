@@ -0,0 +1,41 @@
+// Wait-free single-producer/single-consumer ring of audio commands. The game
+// thread pushes, the audio thread drains at the start of each block; neither
+// side ever blocks or takes a lock
+#ifndef AUDIO_QUEUE_H
+#define AUDIO_QUEUE_H
+
+#define AUDIO_QUEUE_SIZE 256   // Commands, a power of two
+
+typedef enum {
+    AUDIO_CMD_PLAY,          // sound, gain, pan, priority
+    AUDIO_CMD_STOP,          // sound: every voice playing it
+    AUDIO_CMD_SET_VOLUME,    // value: music volume 0-10
+    AUDIO_CMD_SET_PAN        // sound, pan: every voice playing it
+} AudioCommandType;
+
+typedef struct {
+    AudioCommandType type;
+    int sound;
+    int priority;
+    int value;
+    float gain;
+    float pan;
+    unsigned int timeUs;     // Low bits of platformWallTimeUs when sent, for latency
+} AudioCommand;
+
+// head and tail sit on their own cache lines so the two threads do not keep
+// stealing one line from each other
+typedef struct {
+    AudioCommand slots[AUDIO_QUEUE_SIZE];
+    unsigned int head __attribute__((aligned(64)));   // Written by the producer only
+    unsigned int overflows;                           // Pushes refused because the ring was full
+    unsigned int tail __attribute__((aligned(64)));   // Written by the consumer only
+} AudioQueue;
+
+void audioQueueInit(AudioQueue* q);
+// Producer side. Returns -1, dropping the command, if the ring is full
+int audioQueuePush(AudioQueue* q, const AudioCommand* command);
+// Consumer side. Returns 0 when the ring is empty
+int audioQueuePop(AudioQueue* q, AudioCommand* command);
+
+#endif
@@ -0,0 +1,108 @@
+#include <math.h>
+
+#include "cull.h"
+#include "meshes.h"
+
+void cameraView(float x, float y, float z, float eye[3], float center[3]) {
+    eye[0] = x;    eye[1] = y + 1.5f; eye[2] = z + 3.5f;
+    center[0] = x; center[1] = y;     center[2] = z - 2;
+}
+
+float cullEnemyRadius(void) {
+    static float radius;
+    if(radius == 0) radius = meshRadius(MESH_ENEMY_BASIC, MESH_ENEMY_SPEEDSTER);
+    return radius;
+}
+
+static float dot(const float a[3], const float b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void cross(const float a[3], const float b[3], float out[3]) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static void normalize(float v[3]) {
+    float length = sqrtf(dot(v, v));
+    v[0] /= length; v[1] /= length; v[2] /= length;
+}
+
+// Plane through eye + forward * offset with the given inward normal
+static void setPlane(float plane[4], const float normal[3], const float eye[3], float offset, const float forward[3]) {
+    float n[3] = {normal[0], normal[1], normal[2]};
+    normalize(n);
+    float point[3] = {eye[0] + forward[0] * offset, eye[1] + forward[1] * offset, eye[2] + forward[2] * offset};
+    plane[0] = n[0]; plane[1] = n[1]; plane[2] = n[2];
+    plane[3] = -dot(n, point);
+}
+
+// Built from the camera's axes rather than a matrix: the side planes lean
+// out from the view direction by the half-angles of the field of view
+void frustumBuild(Frustum* f, float fovDegrees, float aspect, float zNear, float zFar,
+                  const float eye[3], const float center[3], const float up[3]) {
+    float forward[3] = {center[0] - eye[0], center[1] - eye[1], center[2] - eye[2]};
+    float right[3], camUp[3];
+    normalize(forward);
+    cross(forward, up, right);
+    normalize(right);
+    cross(right, forward, camUp);
+
+    float tanY = tanf(fovDegrees * 3.14159265f / 360.0f);
+    float tanX = tanY * aspect;
+    float back[3] = {-forward[0], -forward[1], -forward[2]};
+    float n[3];
+
+    setPlane(f->planes[0], forward, eye, zNear, forward);
+    setPlane(f->planes[1], back, eye, zFar, forward);
+    for(int i = 0; i < 3; i++) n[i] = right[i] + forward[i] * tanX;
+    setPlane(f->planes[2], n, eye, 0, forward);
+    for(int i = 0; i < 3; i++) n[i] = -right[i] + forward[i] * tanX;
+    setPlane(f->planes[3], n, eye, 0, forward);
+    for(int i = 0; i < 3; i++) n[i] = camUp[i] + forward[i] * tanY;
+    setPlane(f->planes[4], n, eye, 0, forward);
+    for(int i = 0; i < 3; i++) n[i] = -camUp[i] + forward[i] * tanY;
+    setPlane(f->planes[5], n, eye, 0, forward);
+}
+
+void cameraFrustum(Frustum* f, float x, float y, float z) {
+    float eye[3], center[3];
+    const float up[3] = {0, 1, 0};
+    cameraView(x, y, z, eye, center);
+    frustumBuild(f, CAMERA_FOV, CAMERA_ASPECT, CAMERA_NEAR, CAMERA_FAR, eye, center, up);
+}
+
+int frustumSphere(const Frustum* f, float x, float y, float z, float radius) {
+    for(int i = 0; i < 6; i++) {
+        const float* p = f->planes[i];
+        if(p[0] * x + p[1] * y + p[2] * z + p[3] < -radius) return 0;
+    }
+    return 1;
+}
+
+static float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+static int culledIn(const Frustum* f, const float* prevX, const float* x, const float* prevY, const float* y,
+                    const float* prevZ, const float* z, int count, float alpha, float radius) {
+    int culled = 0;
+    for(int i = 0; i < count; i++)
+        culled += !frustumSphere(f, lerp(prevX[i], x[i], alpha), lerp(prevY[i], y[i], alpha),
+                                 lerp(prevZ[i], z[i], alpha), radius);
+    return culled;
+}
+
+void countCulled(const Game* g, const Frustum* f, float alpha, CullStats* out) {
+    const Enemies* e = &g->enemies;
+    const Bullets* b = &g->bullets;
+    const EnemyBullets* eb = &g->enemyBullets;
+    const Particles* p = &g->particles;
+    out->enemies = culledIn(f, e->prevX, e->x, e->prevY, e->y, e->prevZ, e->z, e->pool.count, alpha, cullEnemyRadius());
+    out->bullets = culledIn(f, b->prevX, b->x, b->prevY, b->y, b->prevZ, b->z, b->pool.count, alpha, CULL_BULLET_RADIUS);
+    out->enemyBullets = culledIn(f, eb->prevX, eb->x, eb->prevY, eb->y, eb->prevZ, eb->z, eb->pool.count, alpha,
+                                 CULL_BULLET_RADIUS);
+    out->particles = culledIn(f, p->prevX, p->x, p->prevY, p->y, p->prevZ, p->z, p->pool.count, alpha,
+                              CULL_PARTICLE_RADIUS);
+}
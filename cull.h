@@ -0,0 +1,50 @@
+// View-frustum culling. The camera is described once here and both the
+// renderer's projection and the culling frustum are built from it, so what is
+// culled is exactly what would have been clipped. Every entity is bounded by
+// a sphere and tested against the six frustum planes before it is drawn
+#ifndef CULL_H
+#define CULL_H
+
+#include "game.h"
+
+#define CAMERA_FOV 75.0f               // Vertical, in degrees
+#define CAMERA_ASPECT (16.0f / 9.0f)
+#define CAMERA_NEAR 0.5f
+#define CAMERA_FAR 1000.0f
+
+// Bounding sphere radii: a cube of half-size s reaches s * sqrt(3) and a spark
+// is a square of half-size 0.06. Enemies rotate about their origin, so their
+// radius is the furthest vertex of any baked enemy mesh; see cullEnemyRadius
+#define CULL_BULLET_RADIUS 0.14f
+#define CULL_PARTICLE_RADIUS 0.085f
+
+// Planes as (nx, ny, nz, d) with unit normals pointing inward: a point p is
+// inside a plane when dot(n, p) + d >= 0
+typedef struct {
+    float planes[6][4];
+} Frustum;
+
+typedef struct {
+    int enemies;
+    int bullets;
+    int enemyBullets;
+    int particles;
+} CullStats;
+
+// Bounding radius of every enemy mesh, measured from the baked shapes on
+// first use
+float cullEnemyRadius(void);
+// Where the camera sits and looks for a given player position
+void cameraView(float x, float y, float z, float eye[3], float center[3]);
+// Frustum of a perspective camera at eye looking at center, as
+// sceGumPerspective and sceGumLookAt set it up
+void frustumBuild(Frustum* f, float fovDegrees, float aspect, float zNear, float zFar,
+                  const float eye[3], const float center[3], const float up[3]);
+// The camera's frustum for a given player position
+void cameraFrustum(Frustum* f, float x, float y, float z);
+// False only when the sphere is wholly outside one of the planes
+int frustumSphere(const Frustum* f, float x, float y, float z, float radius);
+// Entities the renderer would cull at this alpha, without drawing anything
+void countCulled(const Game* g, const Frustum* f, float alpha, CullStats* out);
+
+#endif
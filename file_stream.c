@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "file_stream.h"
+#include "platform.h"
+
+// Stats are written only by the stream's thread; other threads take a copy
+static void count(unsigned int* counter, unsigned int n) {
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+static int holds(const FileStream* s, int b, long position) {
+    return position >= s->offset[b] && position < s->offset[b] + s->length[b];
+}
+
+// Whether the read in flight will bring position in
+static int coming(const FileStream* s, long position) {
+    return s->pending >= 0 && position >= s->offset[s->pending] &&
+           position < s->offset[s->pending] + FILE_STREAM_CHUNK;
+}
+
+// Start filling a buffer with the chunk at offset
+static void startFill(FileStream* s, int b, long offset) {
+    s->offset[b] = offset;
+    s->length[b] = 0;
+    if(offset >= s->size) return;
+
+    long size = s->size - offset;
+    if(size > FILE_STREAM_CHUNK) size = FILE_STREAM_CHUNK;
+    if(platformFileReadAsync(s->fd, s->base + offset, s->buffers[b], (int)size) < 0) return;
+    s->pending = b;
+    count(&s->stats.fileReads, 1);
+}
+
+// Collect the read in flight, if any. A stall is the caller waiting for data
+// it needs; waiting to clear the way for another read does not count
+static void finishFill(FileStream* s, int needed) {
+    if(s->pending < 0) return;
+    int stalled = needed && !platformFileReady(s->fd);
+    uint64_t start = platformWallTimeUs();
+    int bytes = platformFileWait(s->fd);
+    if(stalled) {
+        count(&s->stats.stalls, 1);
+        count(&s->stats.stallUs, (unsigned int)(platformWallTimeUs() - start));
+    }
+    s->length[s->pending] = bytes > 0 ? bytes : 0;
+    s->pending = -1;
+}
+
+// Keep the chunk after the current one coming in the other buffer. Past the
+// end that is the chunk the reader loops back to, if it said where
+static void readAhead(FileStream* s) {
+    if(s->pending >= 0 || s->length[s->current] == 0) return;
+    int other = s->current ^ 1;
+    long next = s->offset[s->current] + s->length[s->current];
+    if(next >= s->size) {
+        if(s->loopTo < 0) return;
+        next = s->loopTo - s->loopTo % FILE_STREAM_CHUNK;
+    }
+    if(s->length[other] > 0 && s->offset[other] == next) return;
+    startFill(s, other, next);
+}
+
+// The buffer holding position, read in if need be, or -1 at the end
+static int bufferFor(FileStream* s, long position) {
+    if(position >= s->size) return -1;
+    for(int b = 0; b < 2; b++)
+        if(b != s->pending && holds(s, b, position)) return b;
+
+    // Wanted data is on its way
+    int b = s->pending;
+    if(coming(s, position)) {
+        finishFill(s, 1);
+        return holds(s, b, position) ? b : -1;
+    }
+
+    // A miss: read the chunk around position straight away
+    finishFill(s, 0);
+    b = s->current ^ 1;
+    startFill(s, b, position - position % FILE_STREAM_CHUNK);
+    finishFill(s, 1);
+    return holds(s, b, position) ? b : -1;
+}
+
+int fileStreamOpen(FileStream* s, const char* path, long offset, long size) {
+    s->fd = platformFileOpen(path);
+    if(s->fd < 0) return -1;
+    long fileSize = platformFileSeek(s->fd, 0, SEEK_END);
+    if(size < 0) size = fileSize - offset;
+    if(offset < 0 || size < 0 || offset + size > fileSize) {
+        platformFileClose(s->fd);
+        return -1;
+    }
+    s->base = offset;
+    s->size = size;
+    memset(&s->stats, 0, sizeof(s->stats));
+    s->offset[0] = s->offset[1] = 0;
+    s->length[0] = s->length[1] = 0;
+    s->current = 0;
+    s->pending = -1;
+    s->position = 0;
+    s->loopTo = -1;
+
+    // Start the first chunk now; the reader will want it first
+    startFill(s, 0, 0);
+    return 0;
+}
+
+int fileStreamRead(FileStream* s, void* buffer, int size) {
+    count(&s->stats.requests, 1);
+    unsigned char* out = (unsigned char*)buffer;
+    int done = 0;
+
+    while(done < size) {
+        int b = bufferFor(s, s->position);
+        if(b < 0) break;
+        s->current = b;
+
+        long n = s->offset[b] + s->length[b] - s->position;
+        if(n > size - done) n = size - done;
+        memcpy(out + done, s->buffers[b] + (s->position - s->offset[b]), n);
+        s->position += n;
+        done += (int)n;
+        readAhead(s);
+    }
+    return done;
+}
+
+long fileStreamSeek(FileStream* s, long offset, int whence) {
+    long base = whence == SEEK_CUR ? s->position : whence == SEEK_END ? s->size : 0;
+    if(base + offset < 0) return -1;
+    s->position = base + offset;
+
+    count(&s->stats.seeks, 1);
+    if(holds(s, 0, s->position) || holds(s, 1, s->position) || coming(s, s->position))
+        count(&s->stats.seeksBuffered, 1);
+    return s->position;
+}
+
+long fileStreamTell(const FileStream* s) {
+    return s->position;
+}
+
+void fileStreamLoop(FileStream* s, long offset) {
+    s->loopTo = (offset >= 0 && offset < s->size) ? offset : -1;
+}
+
+void fileStreamClose(FileStream* s) {
+    finishFill(s, 0);
+    platformFileClose(s->fd);
+    s->fd = -1;
+}
+
+void fileStreamStats(const FileStream* s, FileStreamStats* out) {
+    out->requests = __atomic_load_n(&s->stats.requests, __ATOMIC_RELAXED);
+    out->fileReads = __atomic_load_n(&s->stats.fileReads, __ATOMIC_RELAXED);
+    out->seeks = __atomic_load_n(&s->stats.seeks, __ATOMIC_RELAXED);
+    out->seeksBuffered = __atomic_load_n(&s->stats.seeksBuffered, __ATOMIC_RELAXED);
+    out->stalls = __atomic_load_n(&s->stats.stalls, __ATOMIC_RELAXED);
+    out->stallUs = __atomic_load_n(&s->stats.stallUs, __ATOMIC_RELAXED);
+}
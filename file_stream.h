@@ -0,0 +1,49 @@
+// Read-ahead file stream for the music decoder. The file, or a stretch of it,
+// is read in large aligned chunks into two buffers: the caller copies out of
+// one while the next chunk arrives in the other through an asynchronous read.
+// Small reads, seeks and tells are served from the buffers, so the decoder's
+// many small requests become one file read per chunk. Not thread-safe: one
+// thread uses a stream, other threads may only take its stats
+#ifndef FILE_STREAM_H
+#define FILE_STREAM_H
+
+#define FILE_STREAM_CHUNK (32 * 1024)   // Bytes per read; chunks start at multiples of it from the base
+
+typedef struct {
+    unsigned int requests;       // Reads asked of the stream
+    unsigned int fileReads;      // Reads issued to the file
+    unsigned int seeks;
+    unsigned int seeksBuffered;  // Seeks that landed inside a buffered chunk
+    unsigned int stalls;         // Times the caller waited on the file
+    unsigned int stallUs;
+} FileStreamStats;
+
+typedef struct {
+    unsigned char buffers[2][FILE_STREAM_CHUNK] __attribute__((aligned(64)));
+    long offset[2];              // File offset of each buffer
+    int length[2];               // Valid bytes in each; 0 while empty or filling
+    int current;                 // Buffer the last read came from
+    int pending;                 // Buffer an asynchronous read is filling, or -1
+    int fd;
+    long base;                   // Where the stream starts in the file
+    long size;
+    long position;
+    long loopTo;                 // Where the reader goes back to after the end, or -1
+    FileStreamStats stats;
+} FileStream;
+
+// Stream size bytes of a file from offset; size < 0 runs to the end of the
+// file. Returns < 0 if the file cannot be opened or is too short
+int fileStreamOpen(FileStream* s, const char* path, long offset, long size);
+// Returns the bytes copied, short only at the end of the file or on an error
+int fileStreamRead(FileStream* s, void* buffer, int size);
+// whence is SEEK_SET/CUR/END. Returns the new position, or -1
+long fileStreamSeek(FileStream* s, long offset, int whence);
+long fileStreamTell(const FileStream* s);
+// Tell the stream that the reader seeks back to offset once it reaches the
+// end, so the read-ahead fetches that chunk there instead of stopping
+void fileStreamLoop(FileStream* s, long offset);
+void fileStreamClose(FileStream* s);
+void fileStreamStats(const FileStream* s, FileStreamStats* out);
+
+#endif
@@ -0,0 +1,173 @@
+#include <pspkernel.h>
+#include <pspgu.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "font_psp.h"
+
+#define GLYPH_SIZE 8
+#define CELL_WIDTH 7
+#define ATLAS_SIZE 128      // 16x16 glyphs of 8x8
+#define HUD_BACK_COLOR 0x80000000
+
+// 8x8 font that libpspdebug prints with: 256 glyphs, one byte per row, MSB left
+extern unsigned char msx[];
+
+typedef struct {
+    unsigned short u, v;
+    unsigned int color;
+    short x, y, z;
+    short pad;
+} GlyphVertex;
+
+typedef struct {
+    unsigned int color;
+    short x, y, z;
+    short pad;
+} BoxVertex;
+
+#define GLYPH_VERTEX_TYPE (GU_TEXTURE_16BIT|GU_COLOR_8888|GU_VERTEX_16BIT|GU_TRANSFORM_2D)
+#define BOX_VERTEX_TYPE (GU_COLOR_8888|GU_VERTEX_16BIT|GU_TRANSFORM_2D)
+
+typedef struct {
+    char text[HUD_COLUMNS + 1];
+    int column;
+    unsigned int color;
+    int glyphs;      // Sprites laid out (spaces take none)
+    int length;
+    int used;        // Printed this frame
+} HudRow;
+
+static unsigned short __attribute__((aligned(16))) fontAtlas[ATLAS_SIZE * ATLAS_SIZE];
+// Two sets of rows, one per display-list buffer: the GE may still be reading
+// last frame's vertices while this frame's are laid out. Each set is compared
+// against what it held two frames ago
+static GlyphVertex __attribute__((aligned(16))) rowVertices[2][HUD_ROWS][HUD_COLUMNS * 2];
+static HudRow rowSets[2][HUD_ROWS];
+static HudRow* rows = rowSets[0];
+static int currentSet = 0;
+static HudStats stats, frameStats;
+
+// Expand the 1-bit font into a white GU_PSM_4444 atlas; alpha carries the glyph
+void hudInit(void) {
+    for(int c = 0; c < 256; c++) {
+        int ox = (c % 16) * GLYPH_SIZE;
+        int oy = (c / 16) * GLYPH_SIZE;
+        for(int y = 0; y < GLYPH_SIZE; y++) {
+            unsigned char bits = msx[c * GLYPH_SIZE + y];
+            for(int x = 0; x < GLYPH_SIZE; x++) {
+                fontAtlas[(oy + y) * ATLAS_SIZE + ox + x] = (bits & (0x80 >> x)) ? 0xFFFF : 0x0000;
+            }
+        }
+    }
+    sceKernelDcacheWritebackRange(fontAtlas, sizeof(fontAtlas));
+
+    memset(rowSets, 0, sizeof(rowSets));
+    for(int r = 0; r < HUD_ROWS; r++) {
+        rowSets[0][r].column = -1;  // Force the first layout
+        rowSets[1][r].column = -1;
+    }
+}
+
+static void layoutRow(int row) {
+    HudRow* r = &rows[row];
+    GlyphVertex* v = rowVertices[currentSet][row];
+    int n = 0;
+
+    for(int i = 0; i < r->length; i++) {
+        unsigned char c = (unsigned char)r->text[i];
+        if(c == ' ') continue;
+        unsigned short u = (c % 16) * GLYPH_SIZE;
+        unsigned short tv = (c / 16) * GLYPH_SIZE;
+        short x = (r->column + i) * CELL_WIDTH;
+        short y = row * GLYPH_SIZE;
+
+        v[n].u = u; v[n].v = tv; v[n].color = r->color;
+        v[n].x = x; v[n].y = y; v[n].z = 0;
+        n++;
+        v[n].u = u + GLYPH_SIZE; v[n].v = tv + GLYPH_SIZE; v[n].color = r->color;
+        v[n].x = x + GLYPH_SIZE; v[n].y = y + GLYPH_SIZE; v[n].z = 0;
+        n++;
+    }
+    r->glyphs = n / 2;
+
+    // The GE reads these straight from memory
+    sceKernelDcacheWritebackRange(v, n * sizeof(GlyphVertex));
+}
+
+// Put one line of text on a row for this frame. Unchanged text reuses the
+// vertices from the last layout
+void hudPrint(int row, int column, unsigned int color, const char* format, ...) {
+    if(row < 0 || row >= HUD_ROWS || column < 0 || column >= HUD_COLUMNS) return;
+
+    char text[HUD_COLUMNS + 1];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    int length = strlen(text);
+    if(length > HUD_COLUMNS - column) length = HUD_COLUMNS - column;
+    text[length] = '\0';
+
+    HudRow* r = &rows[row];
+    r->used = 1;
+    if(r->column == column && r->color == color && strcmp(r->text, text) == 0) return;
+
+    memcpy(r->text, text, length + 1);
+    r->length = length;
+    r->column = column;
+    r->color = color;
+    layoutRow(row);
+    frameStats.rebuilt++;
+}
+
+// Emit this frame's rows: one sprite batch of translucent backing boxes,
+// then one textured sprite batch per row
+void hudDraw(void) {
+    int used = 0;
+    for(int r = 0; r < HUD_ROWS; r++) used += rows[r].used;
+
+    if(used > 0) {
+        BoxVertex* box = (BoxVertex*)sceGuGetMemory(used * 2 * sizeof(BoxVertex));
+        int n = 0;
+        for(int r = 0; r < HUD_ROWS; r++) {
+            if(!rows[r].used) continue;
+            box[n].color = HUD_BACK_COLOR;
+            box[n].x = rows[r].column * CELL_WIDTH; box[n].y = r * GLYPH_SIZE; box[n].z = 0;
+            n++;
+            box[n].color = HUD_BACK_COLOR;
+            box[n].x = (rows[r].column + rows[r].length) * CELL_WIDTH; box[n].y = (r + 1) * GLYPH_SIZE; box[n].z = 0;
+            n++;
+        }
+
+        sceGuEnable(GU_BLEND);
+        sceGuBlendFunc(GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0);
+        sceGuDrawArray(GU_SPRITES, BOX_VERTEX_TYPE, n, 0, box);
+
+        sceGuEnable(GU_TEXTURE_2D);
+        sceGuTexMode(GU_PSM_4444, 0, 0, 0);
+        sceGuTexImage(0, ATLAS_SIZE, ATLAS_SIZE, ATLAS_SIZE, fontAtlas);
+        sceGuTexFunc(GU_TFX_MODULATE, GU_TCC_RGBA);
+        sceGuTexFilter(GU_NEAREST, GU_NEAREST);
+        for(int r = 0; r < HUD_ROWS; r++) {
+            if(!rows[r].used || rows[r].glyphs == 0) continue;
+            sceGuDrawArray(GU_SPRITES, GLYPH_VERTEX_TYPE, rows[r].glyphs * 2, 0, rowVertices[currentSet][r]);
+            frameStats.glyphs += rows[r].glyphs;
+        }
+        sceGuDisable(GU_TEXTURE_2D);
+        sceGuDisable(GU_BLEND);
+    }
+
+    frameStats.rows = used;
+    stats = frameStats;
+    memset(&frameStats, 0, sizeof(frameStats));
+    for(int r = 0; r < HUD_ROWS; r++) rows[r].used = 0;
+    currentSet ^= 1;
+    rows = rowSets[currentSet];
+}
+
+const HudStats* hudStats(void) {
+    return &stats;
+}
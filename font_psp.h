@@ -0,0 +1,23 @@
+// HUD text drawn by the GE. The debug font is baked once into a texture
+// atlas and every screen row of text becomes GU_SPRITES in the frame's
+// display list. Each row keeps its laid-out vertices and is only rebuilt
+// when its text, position or color changes
+#ifndef FONT_PSP_H
+#define FONT_PSP_H
+
+// Same 68x34 character grid pspDebugScreen used (7x8 pixel cells)
+#define HUD_COLUMNS 68
+#define HUD_ROWS 34
+
+typedef struct {
+    int rows;        // Rows drawn last frame
+    int rebuilt;     // Of those, rows laid out again because they changed
+    int glyphs;
+} HudStats;
+
+void hudInit(void);
+void hudPrint(int row, int column, unsigned int color, const char* format, ...) __attribute__((format(printf, 4, 5)));
+void hudDraw(void);
+const HudStats* hudStats(void);
+
+#endif
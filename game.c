@@ -0,0 +1,840 @@
+#include <math.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+
+#include "game.h"
+#include "platform.h"
+#include "audio.h"
+#include "profiler.h"
+
+static CollisionScratch collision;
+
+// All gameplay randomness comes from the game's own generator, so a seed and
+// the per-tick input are enough to reproduce a session
+int randInt(Game* g, int max) {
+    g->rngState = (g->rngState * 1103515245 + 12345) & 0x7fffffff;
+    return g->rngState % max;
+}
+
+// Claim a slot at the end of the live range, or -1 if the pool is full
+int poolAlloc(Pool* p) {
+    if(p->count >= p->capacity) {
+        p->failures++;
+        return -1;
+    }
+    return p->count++;
+}
+
+// Shrink the live range by one and return the index of the item that must
+// be moved into the freed slot
+int poolFree(Pool* p) {
+    return --p->count;
+}
+
+static void initPool(Pool* p, int capacity) {
+    p->count = 0;
+    p->capacity = capacity;
+    p->failures = 0;
+}
+
+// Cache-line aligned block from the arena, padded to whole lines, or NULL
+// once it is exhausted (and always NULL while measuring)
+void* arenaAlloc(Arena* a, size_t size) {
+    size_t offset = (a->used + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+    a->used = offset + ((size + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1));
+    if(!a->base || a->used > a->size) return NULL;
+    return a->base + offset;
+}
+
+static void carveGrid(Arena* a, SpatialGrid* grid, int capacity) {
+    unsigned int buckets = 64;
+    while(buckets < (unsigned int)capacity * 2) buckets <<= 1;
+
+    grid->bucketMask = buckets - 1;
+    grid->start = (int*)arenaAlloc(a, (buckets + 1) * sizeof(int));
+    grid->cursor = (int*)arenaAlloc(a, buckets * sizeof(int));
+    grid->items = (int*)arenaAlloc(a, capacity * sizeof(int));
+    grid->bucketOf = (unsigned int*)arenaAlloc(a, capacity * sizeof(unsigned int));
+}
+
+// Lay out the game, every entity array and the collision scratch in the arena
+static Game* carveGame(Arena* a, const Capacities* caps) {
+    Game* g = (Game*)arenaAlloc(a, sizeof(Game));
+    static Game layout;
+    if(!g) g = &layout;  // Measuring: carve into a throwaway struct
+
+    Bullets* b = &g->bullets;
+    b->x = (float*)arenaAlloc(a, caps->bullets * sizeof(float));
+    b->y = (float*)arenaAlloc(a, caps->bullets * sizeof(float));
+    b->z = (float*)arenaAlloc(a, caps->bullets * sizeof(float));
+    b->prevX = (float*)arenaAlloc(a, caps->bullets * sizeof(float));
+    b->prevY = (float*)arenaAlloc(a, caps->bullets * sizeof(float));
+    b->prevZ = (float*)arenaAlloc(a, caps->bullets * sizeof(float));
+    initPool(&b->pool, caps->bullets);
+
+    Enemies* e = &g->enemies;
+    e->x = (float*)arenaAlloc(a, caps->enemies * sizeof(float));
+    e->y = (float*)arenaAlloc(a, caps->enemies * sizeof(float));
+    e->z = (float*)arenaAlloc(a, caps->enemies * sizeof(float));
+    e->angle = (float*)arenaAlloc(a, caps->enemies * sizeof(float));
+    e->prevX = (float*)arenaAlloc(a, caps->enemies * sizeof(float));
+    e->prevY = (float*)arenaAlloc(a, caps->enemies * sizeof(float));
+    e->prevZ = (float*)arenaAlloc(a, caps->enemies * sizeof(float));
+    e->prevAngle = (float*)arenaAlloc(a, caps->enemies * sizeof(float));
+    e->moveTimer = (float*)arenaAlloc(a, caps->enemies * sizeof(float));
+    e->shootTimer = (int*)arenaAlloc(a, caps->enemies * sizeof(int));
+    e->health = (int*)arenaAlloc(a, caps->enemies * sizeof(int));
+    e->type = (EnemyType*)arenaAlloc(a, caps->enemies * sizeof(EnemyType));
+    initPool(&e->pool, caps->enemies);
+
+    EnemyBullets* eb = &g->enemyBullets;
+    eb->x = (float*)arenaAlloc(a, caps->enemyBullets * sizeof(float));
+    eb->y = (float*)arenaAlloc(a, caps->enemyBullets * sizeof(float));
+    eb->z = (float*)arenaAlloc(a, caps->enemyBullets * sizeof(float));
+    eb->prevX = (float*)arenaAlloc(a, caps->enemyBullets * sizeof(float));
+    eb->prevY = (float*)arenaAlloc(a, caps->enemyBullets * sizeof(float));
+    eb->prevZ = (float*)arenaAlloc(a, caps->enemyBullets * sizeof(float));
+    initPool(&eb->pool, caps->enemyBullets);
+
+    Particles* p = &g->particles;
+    p->x = (float*)arenaAlloc(a, caps->particles * sizeof(float));
+    p->y = (float*)arenaAlloc(a, caps->particles * sizeof(float));
+    p->z = (float*)arenaAlloc(a, caps->particles * sizeof(float));
+    p->vx = (float*)arenaAlloc(a, caps->particles * sizeof(float));
+    p->vy = (float*)arenaAlloc(a, caps->particles * sizeof(float));
+    p->vz = (float*)arenaAlloc(a, caps->particles * sizeof(float));
+    p->prevX = (float*)arenaAlloc(a, caps->particles * sizeof(float));
+    p->prevY = (float*)arenaAlloc(a, caps->particles * sizeof(float));
+    p->prevZ = (float*)arenaAlloc(a, caps->particles * sizeof(float));
+    p->life = (int*)arenaAlloc(a, caps->particles * sizeof(int));
+    p->color = (unsigned int*)arenaAlloc(a, caps->particles * sizeof(unsigned int));
+    initPool(&p->pool, caps->particles);
+
+    int maxItems = caps->enemies > caps->enemyBullets ? caps->enemies : caps->enemyBullets;
+    carveGrid(a, &collision.enemyGrid, caps->enemies);
+    carveGrid(a, &collision.enemyBulletGrid, caps->enemyBullets);
+    collision.candidates = (int*)arenaAlloc(a, maxItems * sizeof(int));
+    collision.bulletDead = (unsigned char*)arenaAlloc(a, caps->bullets);
+    collision.enemyDead = (unsigned char*)arenaAlloc(a, caps->enemies);
+    collision.enemyBulletDead = (unsigned char*)arenaAlloc(a, caps->enemyBullets);
+
+    return (g == &layout) ? NULL : g;
+}
+
+// Size the arena for these capacities, allocate it in one go and carve the
+// game out of it. Nothing is allocated after this
+Game* createGame(Arena* a, const Capacities* caps) {
+    Arena measure = {NULL, 0, 0};
+    carveGame(&measure, caps);
+
+    a->size = measure.used;
+    a->used = 0;
+    a->base = (unsigned char*)memalign(CACHE_LINE, a->size);
+    if(!a->base) return NULL;
+    memset(a->base, 0, a->size);  // Padding past each pool's count starts as plain zeros
+
+    // Terrain detail is a display setting that outlasts restarts, so it is
+    // set once here rather than in initGame
+    Game* g = carveGame(a, caps);
+    g->config.terrainDetail = TERRAIN_DETAIL_HIGH;
+    return g;
+}
+
+// Read startup settings from the config file. "preset = stress" switches to
+// the high-density budget, and bullets/enemies/enemy_bullets/particles
+// override single pools. seed, record, replay and hash set up replays, and
+// profile names a file for the frame profiler dump.
+// A missing file leaves the defaults
+void loadSettings(const char* filename, Settings* settings) {
+    static const Capacities defaults = {MAX_BULLETS, MAX_ENEMIES, MAX_ENEMY_BULLETS, MAX_PARTICLES};
+    static const Capacities stress = {1000, 500, 1000, 8000};
+    Capacities* caps = &settings->capacities;
+    memset(settings, 0, sizeof(*settings));
+    *caps = defaults;
+    settings->seed = DEFAULT_SEED;
+    settings->audioBlockSamples = AUDIO_DEFAULT_BLOCK_SAMPLES;
+
+    FILE* f = fopen(filename, "r");
+    if(!f) return;
+
+    char line[128], key[32], value[32];
+    while(fgets(line, sizeof(line), f)) {
+        if(line[0] == '#') continue;
+        if(sscanf(line, " %31[^= ] = %31s", key, value) != 2) continue;
+
+        int n = atoi(value);
+        if(strcmp(key, "preset") == 0) {
+            if(strcmp(value, "stress") == 0) *caps = stress;
+            else if(strcmp(value, "default") == 0) *caps = defaults;
+        }
+        else if(strcmp(key, "record") == 0) snprintf(settings->recordPath, sizeof(settings->recordPath), "%s", value);
+        else if(strcmp(key, "replay") == 0) snprintf(settings->replayPath, sizeof(settings->replayPath), "%s", value);
+        else if(strcmp(key, "profile") == 0) snprintf(settings->profilePath, sizeof(settings->profilePath), "%s", value);
+        else if(strcmp(key, "seed") == 0) settings->seed = (unsigned int)strtoul(value, NULL, 10);
+        else if(strcmp(key, "hash") == 0) settings->hashTicks = (n != 0);
+        else if(n <= 0) continue;
+        else if(strcmp(key, "bullets") == 0) caps->bullets = n;
+        else if(strcmp(key, "enemies") == 0) caps->enemies = n;
+        else if(strcmp(key, "enemy_bullets") == 0) caps->enemyBullets = n;
+        else if(strcmp(key, "particles") == 0) caps->particles = n;
+        else if(strcmp(key, "audio_block") == 0) settings->audioBlockSamples = n;
+        else if(strcmp(key, "late_latch") == 0) settings->lateLatch = n;
+    }
+    fclose(f);
+}
+
+void freeBullet(Game* g, int i) {
+    Bullets* b = &g->bullets;
+    int last = poolFree(&b->pool);
+    b->x[i] = b->x[last]; b->y[i] = b->y[last]; b->z[i] = b->z[last];
+    b->prevX[i] = b->prevX[last]; b->prevY[i] = b->prevY[last]; b->prevZ[i] = b->prevZ[last];
+}
+
+void freeEnemy(Game* g, int i) {
+    Enemies* e = &g->enemies;
+    int last = poolFree(&e->pool);
+    e->x[i] = e->x[last]; e->y[i] = e->y[last]; e->z[i] = e->z[last];
+    e->angle[i] = e->angle[last];
+    e->prevX[i] = e->prevX[last]; e->prevY[i] = e->prevY[last]; e->prevZ[i] = e->prevZ[last];
+    e->prevAngle[i] = e->prevAngle[last];
+    e->moveTimer[i] = e->moveTimer[last];
+    e->shootTimer[i] = e->shootTimer[last];
+    e->health[i] = e->health[last];
+    e->type[i] = e->type[last];
+}
+
+void freeEnemyBullet(Game* g, int i) {
+    EnemyBullets* b = &g->enemyBullets;
+    int last = poolFree(&b->pool);
+    b->x[i] = b->x[last]; b->y[i] = b->y[last]; b->z[i] = b->z[last];
+    b->prevX[i] = b->prevX[last]; b->prevY[i] = b->prevY[last]; b->prevZ[i] = b->prevZ[last];
+}
+
+void freeParticle(Game* g, int i) {
+    Particles* p = &g->particles;
+    int last = poolFree(&p->pool);
+    p->x[i] = p->x[last]; p->y[i] = p->y[last]; p->z[i] = p->z[last];
+    p->vx[i] = p->vx[last]; p->vy[i] = p->vy[last]; p->vz[i] = p->vz[last];
+    p->prevX[i] = p->prevX[last]; p->prevY[i] = p->prevY[last]; p->prevZ[i] = p->prevZ[last];
+    p->life[i] = p->life[last];
+    p->color[i] = p->color[last];
+}
+
+void seedGame(Game* g, unsigned int seed) {
+    g->rngState = seed;
+}
+
+void initGame(Game* g) {
+    g->player.x = 0; g->player.y = 0; g->player.z = 0; g->player.health = 3;
+    g->player.prevX = 0; g->player.prevY = 0; g->player.prevZ = 0;
+    g->bullets.pool.count = 0;
+    g->enemies.pool.count = 0;
+    g->enemyBullets.pool.count = 0;
+    g->particles.pool.count = 0;
+    g->score = 0; g->enemyTimer = 0; g->shootTimer = 0; g->time = 0;
+    g->state = STATE_PLAYING;
+    g->config.musicVolume = 8;  // Default 80%
+}
+
+void shootBullet(Game* g) {
+    if(g->shootTimer > 0) return;
+    int i = poolAlloc(&g->bullets.pool);
+    if(i < 0) return;
+
+    g->bullets.x[i] = g->player.x;
+    g->bullets.y[i] = g->player.y;
+    g->bullets.z[i] = g->player.z - 1;
+    g->bullets.prevX[i] = g->bullets.x[i];
+    g->bullets.prevY[i] = g->bullets.y[i];
+    g->bullets.prevZ[i] = g->bullets.z[i];
+    g->shootTimer = 8;
+    playSound(SOUND_SHOOT, g->player.x);
+}
+
+void spawnEnemy(Game* g) {
+    Enemies* e = &g->enemies;
+    int i = poolAlloc(&e->pool);
+    if(i < 0) return;
+
+    e->x[i] = (randInt(g, 600) - 300) / 100.0f;
+    e->y[i] = (randInt(g, 200) - 100) / 100.0f;
+    e->z[i] = -10;
+    e->angle[i] = 0;
+    e->prevX[i] = e->x[i]; e->prevY[i] = e->y[i]; e->prevZ[i] = e->z[i];
+    e->prevAngle[i] = 0;
+    e->moveTimer[i] = 0;
+    e->shootTimer[i] = 0;
+
+    // Randomly assign enemy type
+    e->type[i] = (EnemyType)(randInt(g, 6));
+
+    // Set health based on type
+    switch(e->type[i]) {
+        case ENEMY_TANK:
+            e->health[i] = 3;
+            break;
+        case ENEMY_SPEEDSTER:
+            e->health[i] = 1;
+            break;
+        default:
+            e->health[i] = 2;
+            break;
+    }
+}
+
+void explode(Game* g, float x, float y, float z) {
+    unsigned int colors[] = {0xFF0000FF, 0xFF0088FF, 0xFF00FFFF};
+    Particles* p = &g->particles;
+    playSound(SOUND_EXPLOSION, x);
+    for(int n = 0; n < 15; n++) {
+        int i = poolAlloc(&p->pool);
+        if(i < 0) break;
+
+        p->x[i] = x; p->y[i] = y; p->z[i] = z;
+        p->prevX[i] = x; p->prevY[i] = y; p->prevZ[i] = z;
+        p->vx[i] = (randInt(g, 200) - 100) / 200.0f;
+        p->vy[i] = (randInt(g, 200) - 100) / 200.0f;
+        p->vz[i] = (randInt(g, 200) - 100) / 200.0f;
+        p->life[i] = 30 + randInt(g, 20);
+        p->color[i] = colors[randInt(g, 3)];
+    }
+}
+
+void shootEnemyBullet(Game* g, float x, float y, float z) {
+    int i = poolAlloc(&g->enemyBullets.pool);
+    if(i < 0) return;
+
+    g->enemyBullets.x[i] = x;
+    g->enemyBullets.y[i] = y;
+    g->enemyBullets.z[i] = z;
+    g->enemyBullets.prevX[i] = x;
+    g->enemyBullets.prevY[i] = y;
+    g->enemyBullets.prevZ[i] = z;
+}
+
+void updateEnemy(Game* g, int i, float baseSpeed) {
+    Enemies* e = &g->enemies;
+
+    if(e->shootTimer[i] > 0) e->shootTimer[i]--;
+    e->moveTimer[i] += 0.05f;
+
+    switch(e->type[i]) {
+        case ENEMY_BASIC:
+            // Flies straight toward player
+            e->z[i] += baseSpeed; // 3d?
+            e->angle[i] += 0.05f;
+            break;
+
+        case ENEMY_ZIGZAG:
+            // Moves side-to-side while approaching
+            e->z[i] += baseSpeed;
+            e->x[i] += sinf(e->moveTimer[i] * 3.0f) * 0.05f;
+            e->angle[i] += 0.08f;
+            break;
+
+        case ENEMY_CIRCLER:
+            // Orbits around player position while slowly approaching
+            e->z[i] += baseSpeed * 0.7f;
+            {
+                float radius = 2.0f;
+                float targetX = g->player.x + cosf(e->moveTimer[i]) * radius;
+                float targetY = g->player.y + sinf(e->moveTimer[i]) * radius;
+                e->x[i] += (targetX - e->x[i]) * 0.02f;
+                e->y[i] += (targetY - e->y[i]) * 0.02f;
+            }
+            e->angle[i] += 0.1f;
+            break;
+
+        case ENEMY_SHOOTER:
+            // Slower movement, fires projectiles
+            e->z[i] += baseSpeed * 0.6f;
+            e->angle[i] += 0.05f;
+            // Shoot at player every 60 frames
+            if(e->shootTimer[i] <= 0 && e->z[i] > -8 && e->z[i] < 0) {
+                shootEnemyBullet(g, e->x[i], e->y[i], e->z[i]);
+                e->shootTimer[i] = 60;
+            }
+            break;
+
+        case ENEMY_TANK:
+            // Slow but tough
+            e->z[i] += baseSpeed * 0.5f;
+            e->angle[i] += 0.03f;
+            break;
+
+        case ENEMY_SPEEDSTER:
+            // Fast erratic movement
+            e->z[i] += baseSpeed * 1.5f;
+            e->x[i] += sinf(e->moveTimer[i] * 5.0f) * 0.08f;
+            e->y[i] += cosf(e->moveTimer[i] * 4.0f) * 0.06f;
+            e->angle[i] += 0.15f;
+            break;
+    }
+}
+
+int getEnemyPoints(EnemyType type) {
+    switch(type) {
+        case ENEMY_TANK: return 30;
+        case ENEMY_SHOOTER: return 25;
+        case ENEMY_CIRCLER: return 20;
+        case ENEMY_SPEEDSTER: return 15;
+        case ENEMY_ZIGZAG: return 12;
+        case ENEMY_BASIC:
+        default: return 10;
+    }
+}
+
+// Collision broadphase: a uniform grid hashed into a power-of-two bucket table
+// and rebuilt every tick. Cells are at least as wide as the largest collision
+// radius (sqrt(0.8)), so every hit lies in the 3x3x3 cells around a point
+static unsigned int gridBucket(const SpatialGrid* grid, int cx, int cy, int cz) {
+    return ((unsigned int)cx * 73856093u ^ (unsigned int)cy * 19349663u ^
+            (unsigned int)cz * 83492791u) & grid->bucketMask;
+}
+
+static int gridCell(float v) {
+    return (int)floorf(v * (1.0f / GRID_CELL_SIZE));
+}
+
+// Counting sort of entity indices by bucket; indices stay ascending within
+// each bucket
+void gridBuild(SpatialGrid* grid, const float* x, const float* y, const float* z, int count) {
+    unsigned int buckets = grid->bucketMask + 1;
+
+    memset(grid->start, 0, (buckets + 1) * sizeof(int));
+    for(int i = 0; i < count; i++) {
+        unsigned int b = gridBucket(grid, gridCell(x[i]), gridCell(y[i]), gridCell(z[i]));
+        grid->bucketOf[i] = b;
+        grid->start[b + 1]++;
+    }
+    for(unsigned int b = 0; b < buckets; b++) {
+        grid->start[b + 1] += grid->start[b];
+        grid->cursor[b] = grid->start[b];
+    }
+    for(int i = 0; i < count; i++) {
+        grid->items[grid->cursor[grid->bucketOf[i]]++] = i;
+    }
+}
+
+// Collect the indices stored in the cells around a point, ascending.
+// Neighbouring cells can hash to the same bucket, so buckets are visited once
+int gridQuery(const SpatialGrid* grid, float x, float y, float z, int* out) {
+    unsigned int seen[27];
+    int buckets = 0, n = 0;
+    int cx = gridCell(x), cy = gridCell(y), cz = gridCell(z);
+
+    for(int dz = -1; dz <= 1; dz++) {
+        for(int dy = -1; dy <= 1; dy++) {
+            for(int dx = -1; dx <= 1; dx++) {
+                unsigned int b = gridBucket(grid, cx + dx, cy + dy, cz + dz);
+                int dup = 0;
+                for(int k = 0; k < buckets; k++) if(seen[k] == b) { dup = 1; break; }
+                if(dup) continue;
+                seen[buckets++] = b;
+                for(int k = grid->start[b]; k < grid->start[b + 1]; k++) out[n++] = grid->items[k];
+            }
+        }
+    }
+
+    // Insertion sort: candidate lists are a handful of entries
+    for(int i = 1; i < n; i++) {
+        int v = out[i], j = i - 1;
+        while(j >= 0 && out[j] > v) { out[j + 1] = out[j]; j--; }
+        out[j + 1] = v;
+    }
+    return n;
+}
+
+static int withinRadius(float ax, float ay, float az, float bx, float by, float bz, float r2) {
+    float dx = ax - bx, dy = ay - by, dz = az - bz;
+    return dx*dx + dy*dy + dz*dz < r2;
+}
+
+// Lowest-index live entity within r2 of a point: through the grid, and the
+// brute-force scan it must always agree with
+static int findFirstHit(const SpatialGrid* grid, const float* x, const float* y, const float* z,
+                        const unsigned char* dead, float px, float py, float pz, float r2) {
+    int n = gridQuery(grid, px, py, pz, collision.candidates);
+    for(int k = 0; k < n; k++) {
+        int j = collision.candidates[k];
+        if(!dead[j] && withinRadius(px, py, pz, x[j], y[j], z[j], r2)) return j;
+    }
+    return -1;
+}
+
+static int findFirstHitBruteForce(const float* x, const float* y, const float* z, int count,
+                                  const unsigned char* dead, float px, float py, float pz, float r2) {
+    for(int j = 0; j < count; j++) {
+        if(!dead[j] && withinRadius(px, py, pz, x[j], y[j], z[j], r2)) return j;
+    }
+    return -1;
+}
+
+int collisionUsesGrid(int count) {
+#if defined(COLLISION_VERIFY)
+    (void)count;
+    return 1;
+#elif defined(COLLISION_BRUTE_FORCE)
+    (void)count;
+    return 0;
+#else
+    return count >= COLLISION_GRID_MIN;
+#endif
+}
+
+// The grid must have been built this tick if collisionUsesGrid(count)
+static int findHit(const SpatialGrid* grid, const float* x, const float* y, const float* z, int count,
+                   const unsigned char* dead, float px, float py, float pz, float r2) {
+    if(!collisionUsesGrid(count)) return findFirstHitBruteForce(x, y, z, count, dead, px, py, pz, r2);
+
+    int hit = findFirstHit(grid, x, y, z, dead, px, py, pz, r2);
+#ifdef COLLISION_VERIFY
+    int expected = findFirstHitBruteForce(x, y, z, count, dead, px, py, pz, r2);
+    if(hit != expected) {
+        if(collision.mismatches++ == 0)
+            platformLog("Collision mismatch: grid hit %d, brute force %d at (%.3f %.3f %.3f)\n",
+                        hit, expected, px, py, pz);
+    }
+#endif
+    return hit;
+}
+
+int collisionMismatches(void) {
+    return collision.mismatches;
+}
+
+// Collision pass. Frees are deferred to the end through the dead flags so
+// indices stay stable while the grids are in use; hits are resolved in the
+// same order the brute-force loops used, so results do not depend on the grid
+void updateCollisions(Game* g) {
+    Enemies* e = &g->enemies;
+    Bullets* b = &g->bullets;
+    EnemyBullets* eb = &g->enemyBullets;
+
+    memset(collision.bulletDead, 0, b->pool.count);
+    memset(collision.enemyDead, 0, e->pool.count);
+    memset(collision.enemyBulletDead, 0, eb->pool.count);
+
+    // Counts hold until the frees at the end, so findHit makes the same choice
+    if(collisionUsesGrid(e->pool.count))
+        gridBuild(&collision.enemyGrid, e->x, e->y, e->z, e->pool.count);
+    if(collisionUsesGrid(eb->pool.count))
+        gridBuild(&collision.enemyBulletGrid, eb->x, eb->y, eb->z, eb->pool.count);
+
+    // Bullet-Enemy collision (with health system): each bullet hits the
+    // first live enemy in range
+    for(int i = 0; i < b->pool.count; i++) {
+        int j = findHit(&collision.enemyGrid, e->x, e->y, e->z, e->pool.count,
+                        collision.enemyDead, b->x[i], b->y[i], b->z[i], 0.5f);
+        if(j < 0) continue;
+
+        collision.bulletDead[i] = 1;
+        e->health[j]--;
+        if(e->health[j] <= 0) {
+            collision.enemyDead[j] = 1;
+            g->score += getEnemyPoints(e->type[j]);
+            explode(g, e->x[j], e->y[j], e->z[j]);
+        }
+    }
+
+    // Enemy bullet-Player collision
+    for(;;) {
+        int i = findHit(&collision.enemyBulletGrid, eb->x, eb->y, eb->z, eb->pool.count,
+                        collision.enemyBulletDead, g->player.x, g->player.y, g->player.z, 0.4f);
+        if(i < 0) break;
+
+        collision.enemyBulletDead[i] = 1;
+        g->player.health--;
+        playSound(SOUND_HIT, g->player.x);
+        if(g->player.health <= 0) {
+            g->state = STATE_GAME_OVER;
+        }
+    }
+
+    // Player-Enemy collision
+    for(;;) {
+        int i = findHit(&collision.enemyGrid, e->x, e->y, e->z, e->pool.count,
+                        collision.enemyDead, g->player.x, g->player.y, g->player.z, 0.8f);
+        if(i < 0) break;
+
+        collision.enemyDead[i] = 1;
+        g->player.health--;
+        playSound(SOUND_HIT, g->player.x);
+        explode(g, e->x[i], e->y[i], e->z[i]);
+        if(g->player.health <= 0) {
+            g->state = STATE_GAME_OVER;
+        }
+    }
+
+    // Release everything that was hit, carrying the flags along with the swaps
+    for(int i = 0; i < b->pool.count; ) {
+        if(collision.bulletDead[i]) {
+            collision.bulletDead[i] = collision.bulletDead[b->pool.count - 1];
+            freeBullet(g, i);
+            continue;
+        }
+        i++;
+    }
+    for(int i = 0; i < e->pool.count; ) {
+        if(collision.enemyDead[i]) {
+            collision.enemyDead[i] = collision.enemyDead[e->pool.count - 1];
+            freeEnemy(g, i);
+            continue;
+        }
+        i++;
+    }
+    for(int i = 0; i < eb->pool.count; ) {
+        if(collision.enemyBulletDead[i]) {
+            collision.enemyBulletDead[i] = collision.enemyBulletDead[eb->pool.count - 1];
+            freeEnemyBullet(g, i);
+            continue;
+        }
+        i++;
+    }
+}
+
+// Movement kernels: branch-free passes over packed arrays that the compiler
+// can vectorize (SSE on host builds) or software-pipeline on the Allegrex.
+// They run to the end of the last cache line in use: the arrays own it, slots
+// past count are overwritten when allocated, and a trip count that is a
+// multiple of the vector width needs no scalar tail, which -O2 requires before
+// it will vectorize. The restrict parameters are what rule out aliasing;
+// restrict locals loaded from a struct do not. Only pools carved by
+// createGame may be passed in; a plain array of count floats would be
+// overrun
+static int wholeLines(int count) {
+    const int perLine = CACHE_LINE / sizeof(float);
+    return (count + perLine - 1) & ~(perLine - 1);
+}
+
+static void moveAlongZ(float* restrict z, int count, float dz) {
+    count = wholeLines(count);
+    for(int i = 0; i < count; i++) z[i] += dz;
+}
+
+static void integrate(float* restrict x, float* restrict y, float* restrict z, const float* restrict vx,
+                      float* restrict vy, const float* restrict vz, int* restrict life, int count) {
+    count = wholeLines(count);
+    for(int i = 0; i < count; i++) {
+        x[i] += vx[i];
+        y[i] += vy[i];
+        z[i] += vz[i];
+        vy[i] -= 0.01f;
+        life[i]--;
+    }
+}
+
+void moveBullets(Bullets* b) {
+    moveAlongZ(b->z, b->pool.count, -0.3f);
+}
+
+void integrateParticles(Particles* p) {
+    integrate(p->x, p->y, p->z, p->vx, p->vy, p->vz, p->life, p->pool.count);
+}
+
+void updateGame(Game* g) {
+    PROFILE_BEGIN(PHASE_MOVE);
+    if(g->shootTimer > 0) g->shootTimer--;
+
+    // Move bullets and enemy bullets, then drop the ones that left the field
+    moveBullets(&g->bullets);
+    for(int i = 0; i < g->bullets.pool.count; ) {
+        if(g->bullets.z[i] < -15) { freeBullet(g, i); continue; }
+        i++;
+    }
+
+    moveAlongZ(g->enemyBullets.z, g->enemyBullets.pool.count, 0.15f);
+    for(int i = 0; i < g->enemyBullets.pool.count; ) {
+        if(g->enemyBullets.z[i] > 5) { freeEnemyBullet(g, i); continue; }
+        i++;
+    }
+
+    // Update enemies (faster as score increases)
+    float enemySpeed = 0.025f + (g->score / 5000.0f);
+    if(enemySpeed > 0.06f) enemySpeed = 0.06f;
+    for(int i = 0; i < g->enemies.pool.count; ) {
+        updateEnemy(g, i, enemySpeed);
+        if(g->enemies.z[i] > 5) { freeEnemy(g, i); continue; }
+        i++;
+    }
+    PROFILE_END(PHASE_MOVE);
+
+    // Update particles
+    PROFILE_BEGIN(PHASE_PARTICLES);
+    integrateParticles(&g->particles);
+    for(int i = 0; i < g->particles.pool.count; ) {
+        if(g->particles.life[i] <= 0) { freeParticle(g, i); continue; }
+        i++;
+    }
+    PROFILE_END(PHASE_PARTICLES);
+
+    PROFILE_BEGIN(PHASE_COLLIDE);
+    updateCollisions(g);
+    PROFILE_END(PHASE_COLLIDE);
+
+    g->time += SIM_DT;
+}
+
+// Snapshot every position before a tick moves them; the renderer blends
+// from this snapshot towards the new state
+static void savePreviousState(Game* g) {
+    Player* pl = &g->player;
+    pl->prevX = pl->x; pl->prevY = pl->y; pl->prevZ = pl->z;
+
+    Bullets* b = &g->bullets;
+    size_t n = b->pool.count * sizeof(float);
+    memcpy(b->prevX, b->x, n); memcpy(b->prevY, b->y, n); memcpy(b->prevZ, b->z, n);
+
+    Enemies* e = &g->enemies;
+    n = e->pool.count * sizeof(float);
+    memcpy(e->prevX, e->x, n); memcpy(e->prevY, e->y, n); memcpy(e->prevZ, e->z, n);
+    memcpy(e->prevAngle, e->angle, n);
+
+    EnemyBullets* eb = &g->enemyBullets;
+    n = eb->pool.count * sizeof(float);
+    memcpy(eb->prevX, eb->x, n); memcpy(eb->prevY, eb->y, n); memcpy(eb->prevZ, eb->z, n);
+
+    Particles* p = &g->particles;
+    n = p->pool.count * sizeof(float);
+    memcpy(p->prevX, p->x, n); memcpy(p->prevY, p->y, n); memcpy(p->prevZ, p->z, n);
+}
+
+// Move a player position by the d-pad over a fraction of a tick, inside the
+// field. Returns the directions that moved it. A whole tick is the real move;
+// the late latch asks for part of one to draw with the newest pad state
+unsigned int stepPlayer(float* x, float* y, unsigned int buttons, float fraction) {
+    unsigned int moved = 0;
+    if(buttons & BUTTON_UP && *y < 1.5f) { *y += 0.06f * fraction; moved |= BUTTON_UP; }
+    if(buttons & BUTTON_DOWN && *y > -1.5f) { *y -= 0.06f * fraction; moved |= BUTTON_DOWN; }
+    if(buttons & BUTTON_LEFT && *x > -3.0f) { *x -= 0.08f * fraction; moved |= BUTTON_LEFT; }
+    if(buttons & BUTTON_RIGHT && *x < 3.0f) { *x += 0.08f * fraction; moved |= BUTTON_RIGHT; }
+    return moved;
+}
+
+// One fixed simulation tick of gameplay. pressed holds the buttons that went
+// down since the previous tick, so a tap is seen exactly once
+void tickGame(Game* g, unsigned int buttons, unsigned int pressed) {
+    savePreviousState(g);
+
+    PROFILE_BEGIN(PHASE_INPUT);
+    stepPlayer(&g->player.x, &g->player.y, buttons, 1.0f);
+    if(pressed & BUTTON_CROSS) shootBullet(g);
+    PROFILE_END(PHASE_INPUT);
+
+    // Spawn enemies (faster as score increases)
+    PROFILE_BEGIN(PHASE_SPAWN);
+    int spawnRate = 80 - (g->score / 50);
+    if(spawnRate < 30) spawnRate = 30;
+    if(++g->enemyTimer > spawnRate) {
+        spawnEnemy(g);
+        g->enemyTimer = 0;
+    }
+    PROFILE_END(PHASE_SPAWN);
+
+    updateGame(g);
+}
+
+void countEntities(const Game* g, int* enemies, int* bullets, int* eBullets, int* particles) {
+    *enemies = g->enemies.pool.count;
+    *bullets = g->bullets.pool.count;
+    *eBullets = g->enemyBullets.pool.count;
+    *particles = g->particles.pool.count;
+}
+
+// FNV-1a over the simulation state: everything a tick reads or writes, live
+// entities only. Render-only copies (prev*) and pool failure counters are
+// left out. Floats are hashed by bit pattern, so hashes only match between
+// builds that do identical float math (same platform and compiler flags)
+static unsigned int hashBytes(unsigned int hash, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Fold this tick's state into the running hash; start from HASH_INIT
+unsigned int hashGame(const Game* g, unsigned int hash) {
+    const Player* pl = &g->player;
+    hash = hashBytes(hash, &pl->x, sizeof(pl->x));
+    hash = hashBytes(hash, &pl->y, sizeof(pl->y));
+    hash = hashBytes(hash, &pl->z, sizeof(pl->z));
+    hash = hashBytes(hash, &pl->health, sizeof(pl->health));
+    hash = hashBytes(hash, &g->score, sizeof(g->score));
+    hash = hashBytes(hash, &g->enemyTimer, sizeof(g->enemyTimer));
+    hash = hashBytes(hash, &g->shootTimer, sizeof(g->shootTimer));
+    hash = hashBytes(hash, &g->rngState, sizeof(g->rngState));
+    hash = hashBytes(hash, &g->time, sizeof(g->time));
+    hash = hashBytes(hash, &g->state, sizeof(g->state));
+
+    const Bullets* b = &g->bullets;
+    size_t n = b->pool.count * sizeof(float);
+    hash = hashBytes(hash, &b->pool.count, sizeof(int));
+    hash = hashBytes(hash, b->x, n);
+    hash = hashBytes(hash, b->y, n);
+    hash = hashBytes(hash, b->z, n);
+
+    const Enemies* e = &g->enemies;
+    n = e->pool.count * sizeof(float);
+    hash = hashBytes(hash, &e->pool.count, sizeof(int));
+    hash = hashBytes(hash, e->x, n);
+    hash = hashBytes(hash, e->y, n);
+    hash = hashBytes(hash, e->z, n);
+    hash = hashBytes(hash, e->angle, n);
+    hash = hashBytes(hash, e->moveTimer, n);
+    hash = hashBytes(hash, e->shootTimer, e->pool.count * sizeof(int));
+    hash = hashBytes(hash, e->health, e->pool.count * sizeof(int));
+    hash = hashBytes(hash, e->type, e->pool.count * sizeof(EnemyType));
+
+    const EnemyBullets* eb = &g->enemyBullets;
+    n = eb->pool.count * sizeof(float);
+    hash = hashBytes(hash, &eb->pool.count, sizeof(int));
+    hash = hashBytes(hash, eb->x, n);
+    hash = hashBytes(hash, eb->y, n);
+    hash = hashBytes(hash, eb->z, n);
+
+    const Particles* p = &g->particles;
+    n = p->pool.count * sizeof(float);
+    hash = hashBytes(hash, &p->pool.count, sizeof(int));
+    hash = hashBytes(hash, p->x, n);
+    hash = hashBytes(hash, p->y, n);
+    hash = hashBytes(hash, p->z, n);
+    hash = hashBytes(hash, p->vx, n);
+    hash = hashBytes(hash, p->vy, n);
+    hash = hashBytes(hash, p->vz, n);
+    hash = hashBytes(hash, p->life, p->pool.count * sizeof(int));
+    hash = hashBytes(hash, p->color, p->pool.count * sizeof(unsigned int));
+    return hash;
+}
+
+// Handle config menu input
+void handleConfigMenuInput(Game* g, unsigned int pressed) {
+    // LEFT: decrease volume
+    if (pressed & BUTTON_LEFT) {
+        if (g->config.musicVolume > 0) {
+            g->config.musicVolume--;
+            setMusicVolume(g->config.musicVolume);
+        }
+    }
+    // RIGHT: increase volume
+    if (pressed & BUTTON_RIGHT) {
+        if (g->config.musicVolume < 10) {
+            g->config.musicVolume++;
+            setMusicVolume(g->config.musicVolume);
+        }
+    }
+    // UP/DOWN: terrain detail
+    if (pressed & BUTTON_UP) {
+        if (g->config.terrainDetail < TERRAIN_DETAIL_COUNT - 1) g->config.terrainDetail++;
+    }
+    if (pressed & BUTTON_DOWN) {
+        if (g->config.terrainDetail > 0) g->config.terrainDetail--;
+    }
+    // X to close menu
+    if (pressed & BUTTON_CROSS) {
+        g->state = STATE_PLAYING;
+    }
+}
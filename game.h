@@ -0,0 +1,242 @@
+// Simulation core: entity storage, gameplay rules and collisions. Nothing in
+// here touches the hardware, so it builds for the PSP and for the headless
+// Linux backend alike (see platform.h)
+#ifndef GAME_H
+#define GAME_H
+
+#include <stddef.h>
+
+// Default entity capacities; game.cfg can override them at startup
+#define MAX_BULLETS 30
+#define MAX_ENEMIES 15
+#define MAX_PARTICLES 100
+#define MAX_ENEMY_BULLETS 20
+
+#define CONFIG_FILE "game.cfg"
+#define DEFAULT_SEED 12345
+
+// Arena allocations start on their own cache line (64 bytes on the Allegrex)
+// and own every line they touch, so loops may run to the end of the last one
+#define CACHE_LINE 64
+
+// The simulation always advances in fixed ticks; rendering interpolates
+// between the last two ticks. MAX_TICKS_PER_FRAME caps the catch-up so a
+// long stall drops time instead of spiralling into ever longer frames
+#define SIM_DT (1.0f / 60.0f)
+#define MAX_TICKS_PER_FRAME 5
+
+// Enemy types
+typedef enum {
+    ENEMY_BASIC,     // Flies straight toward player
+    ENEMY_ZIGZAG,    // Moves side-to-side while approaching
+    ENEMY_CIRCLER,   // Orbits around player position
+    ENEMY_SHOOTER,   // Fires projectiles at player
+    ENEMY_TANK,      // Slower, more health, worth more points
+    ENEMY_SPEEDSTER  // Fast, erratic movement, less health
+} EnemyType;
+
+// Game states
+typedef enum {
+    STATE_PLAYING,
+    STATE_CONFIG_MENU,
+    STATE_GAME_OVER
+} GameState;
+
+// Configuration
+typedef struct {
+    int musicVolume;  // 0-10, default 8
+    int terrainDetail;  // TerrainDetail, default high
+} Config;
+
+// Terrain detail settings, selectable from the config menu
+typedef enum {
+    TERRAIN_DETAIL_LOW,
+    TERRAIN_DETAIL_MEDIUM,
+    TERRAIN_DETAIL_HIGH,
+    TERRAIN_DETAIL_COUNT
+} TerrainDetail;
+
+typedef struct {
+    float x, y, z;
+    float prevX, prevY, prevZ;  // Position at the start of the last tick
+    int health;
+} Player;
+
+// Entity pools: live entities are packed at the front of their arrays.
+// Allocation appends at count, freeing moves the last live entity into the
+// hole, so both are O(1), loops over [0, count) only touch live entities and
+// count is always the live total. Freeing reorders the arrays, so loops that
+// free while iterating must revisit the current index.
+typedef struct {
+    int count;
+    int capacity;
+    int failures;   // Allocations refused because the pool was full
+} Pool;
+
+// Entity capacities, fixed at startup from CONFIG_FILE
+typedef struct {
+    int bullets;
+    int enemies;
+    int enemyBullets;
+    int particles;
+} Capacities;
+
+// Bump allocator over one block carved up at startup. With base == NULL it
+// only measures, so the same carving code sizes the block before it exists
+typedef struct {
+    unsigned char* base;
+    size_t size;
+    size_t used;
+} Arena;
+
+// Entities are stored as structure-of-arrays: one packed, cache-line aligned
+// array per field, so the movement loops in updateGame are straight-line
+// passes over floats. The prev* arrays hold each entity as it was at the
+// start of the last tick, for render interpolation
+typedef struct {
+    float* x;
+    float* y;
+    float* z;
+    float* prevX;
+    float* prevY;
+    float* prevZ;
+    Pool pool;
+} Bullets;
+
+typedef struct {
+    float* x;
+    float* y;
+    float* z;
+    float* angle;
+    float* prevX;
+    float* prevY;
+    float* prevZ;
+    float* prevAngle;
+    float* moveTimer;  // For timing movement patterns
+    int* shootTimer;
+    int* health;
+    EnemyType* type;
+    Pool pool;
+} Enemies;
+
+typedef struct {
+    float* x;
+    float* y;
+    float* z;
+    float* vx;
+    float* vy;
+    float* vz;
+    float* prevX;
+    float* prevY;
+    float* prevZ;
+    int* life;
+    unsigned int* color;
+    Pool pool;
+} Particles;
+
+typedef struct {
+    float* x;
+    float* y;
+    float* z;
+    float* prevX;
+    float* prevY;
+    float* prevZ;
+    Pool pool;
+} EnemyBullets;
+
+// Broadphase grid over one entity kind. GRID_CELL_SIZE must be at least the
+// largest collision radius
+#define GRID_CELL_SIZE 1.0f
+// Below this many entities a kind is scanned by brute force instead: rebuilding
+// its grid every tick costs more than the scan saves. About where
+// --bench-collision has the two cross over on the host
+#define COLLISION_GRID_MIN 256
+
+typedef struct {
+    unsigned int bucketMask;   // Bucket count - 1, a power of two
+    int* start;                // Bucket b owns items[start[b]..start[b + 1])
+    int* cursor;
+    int* items;                // Entity indices sorted by bucket
+    unsigned int* bucketOf;
+} SpatialGrid;
+
+// Per-tick collision scratch; not part of the game state
+typedef struct {
+    SpatialGrid enemyGrid;
+    SpatialGrid enemyBulletGrid;
+    int* candidates;
+    unsigned char* bulletDead;
+    unsigned char* enemyDead;
+    unsigned char* enemyBulletDead;
+    int mismatches;            // Grid vs brute-force disagreements (COLLISION_VERIFY)
+} CollisionScratch;
+
+typedef struct {
+    Player player;
+    Bullets bullets;
+    Enemies enemies;
+    EnemyBullets enemyBullets;
+    Particles particles;
+    int score, enemyTimer, shootTimer;
+    unsigned int rngState;  // randInt state; survives initGame so replays stay in sync
+    float time;
+    GameState state;
+    Config config;
+} Game;
+
+// Startup settings: game.cfg first, then (on Linux) the command line
+typedef struct {
+    Capacities capacities;
+    unsigned int seed;
+    char recordPath[64];  // Record a replay here on exit ("" = off)
+    char replayPath[64];  // Play this replay back instead of running live
+    int hashTicks;        // Store a state hash per tick when recording
+    char profilePath[64]; // Dump the frame profiler here on exit ("" = off)
+    int audioBlockSamples;
+    int lateLatch;        // Re-read the pad for the player and camera just before drawing
+} Settings;
+
+int randInt(Game* g, int max);
+int poolAlloc(Pool* p);
+int poolFree(Pool* p);
+void* arenaAlloc(Arena* a, size_t size);
+Game* createGame(Arena* a, const Capacities* caps);
+void loadSettings(const char* filename, Settings* settings);
+void seedGame(Game* g, unsigned int seed);
+void initGame(Game* g);
+void freeBullet(Game* g, int i);
+void freeEnemy(Game* g, int i);
+void freeEnemyBullet(Game* g, int i);
+void freeParticle(Game* g, int i);
+
+void shootBullet(Game* g);
+void spawnEnemy(Game* g);
+void explode(Game* g, float x, float y, float z);
+void shootEnemyBullet(Game* g, float x, float y, float z);
+void updateEnemy(Game* g, int i, float baseSpeed);
+int getEnemyPoints(EnemyType type);
+
+// Grid answers that differed from brute force; only counted in COLLISION_VERIFY builds
+int collisionMismatches(void);
+// Whether a kind with count live entities is searched through its grid.
+// COLLISION_VERIFY builds always use the grid so that it is checked
+int collisionUsesGrid(int count);
+void gridBuild(SpatialGrid* grid, const float* x, const float* y, const float* z, int count);
+int gridQuery(const SpatialGrid* grid, float x, float y, float z, int* out);
+void updateCollisions(Game* g);
+// updateGame's movement passes over every live bullet and particle. The pools
+// must have been carved by createGame: the kernels write past pool.count to
+// the end of each array's last cache line, which only the arena pads out
+void moveBullets(Bullets* b);
+void integrateParticles(Particles* p);
+
+void updateGame(Game* g);
+void tickGame(Game* g, unsigned int buttons, unsigned int pressed);
+unsigned int stepPlayer(float* x, float* y, unsigned int buttons, float fraction);
+void countEntities(const Game* g, int* enemies, int* bullets, int* eBullets, int* particles);
+void handleConfigMenuInput(Game* g, unsigned int pressed);
+
+#define HASH_INIT 2166136261u
+unsigned int hashGame(const Game* g, unsigned int hash);
+
+#endif
@@ -0,0 +1,56 @@
+#include "loader.h"
+#include "assets.h"
+#include "audio.h"
+#include "platform.h"
+
+static LoadStage stage = LOAD_ARCHIVE;
+static int audioBlockSamples;
+
+static const char* stageNames[] = {
+    "asset archive",
+    "sounds",
+    "music",
+    "done"
+};
+
+// Publish a stage only after its work is done, so a thread that sees it
+// also sees everything it loaded
+static void finishStage(LoadStage next) {
+    __atomic_store_n(&stage, next, __ATOMIC_RELEASE);
+}
+
+static int loaderThread(void* arg) {
+    if(assetsOpen(ASSETS_FILE) < 0) platformLog("Cannot read %s, running without sound\n", ASSETS_FILE);
+    finishStage(LOAD_AUDIO);
+
+    initAudio(audioBlockSamples);
+    finishStage(LOAD_MUSIC);
+
+    startMusic();
+    finishStage(LOAD_DONE);
+    return 0;
+}
+
+void loaderStart(int blockSamples) {
+    audioBlockSamples = blockSamples;
+    if(platformStartThread("loader", loaderThread, NULL, THREAD_PRIORITY_LOADER, 0x10000) < 0) {
+        loaderThread(NULL);  // No thread: load here, before the first frame
+    }
+}
+
+LoadStage loaderStage(void) {
+    return __atomic_load_n(&stage, __ATOMIC_ACQUIRE);
+}
+
+int loaderInteractive(void) {
+    return loaderStage() >= LOAD_MUSIC;
+}
+
+float loaderProgress(void) {
+    LoadStage s = loaderStage();
+    return s >= LOAD_MUSIC ? 1.0f : (float)s / LOAD_MUSIC;
+}
+
+const char* loaderStageName(LoadStage s) {
+    return stageNames[s];
+}
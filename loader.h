@@ -0,0 +1,22 @@
+// Startup loading on a worker thread, so the display is up and showing
+// progress while assets come in. Stages run in order. The game can start once
+// the must-have stages are done; the music keeps warming up behind it
+#ifndef LOADER_H
+#define LOADER_H
+
+typedef enum {
+    LOAD_ARCHIVE,       // Asset archive index and resident assets
+    LOAD_AUDIO,         // Output channel, mixer and sound effects
+    LOAD_MUSIC,         // Music stream opened and the ring filled; not needed to play
+    LOAD_DONE
+} LoadStage;
+
+void loaderStart(int audioBlockSamples);
+LoadStage loaderStage(void);
+// True once everything the game needs to run is resident
+int loaderInteractive(void);
+// How far through the must-have stages, 0..1
+float loaderProgress(void);
+const char* loaderStageName(LoadStage stage);
+
+#endif
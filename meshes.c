@@ -0,0 +1,172 @@
+#include <math.h>
+
+#include "meshes.h"
+
+// Unit cube (half-size 1), scaled per draw. Front, back, top, bottom, left, right
+static const float cubeShape[36][3] = {
+    {-1,-1, 1}, { 1,-1, 1}, { 1, 1, 1}, {-1,-1, 1}, { 1, 1, 1}, {-1, 1, 1},
+    { 1,-1,-1}, {-1,-1,-1}, {-1, 1,-1}, { 1,-1,-1}, {-1, 1,-1}, { 1, 1,-1},
+    {-1, 1, 1}, { 1, 1, 1}, { 1, 1,-1}, {-1, 1, 1}, { 1, 1,-1}, {-1, 1,-1},
+    {-1,-1,-1}, { 1,-1,-1}, { 1,-1, 1}, {-1,-1,-1}, { 1,-1, 1}, {-1,-1, 1},
+    {-1,-1,-1}, {-1,-1, 1}, {-1, 1, 1}, {-1,-1,-1}, {-1, 1, 1}, {-1, 1,-1},
+    { 1,-1, 1}, { 1,-1,-1}, { 1, 1,-1}, { 1,-1, 1}, { 1, 1,-1}, { 1, 1, 1}
+};
+
+static const float wingsShape[6][3] = {
+    {-0.6f, 0, 0}, {-0.2f, 0, -0.2f}, {-0.2f, 0, 0.2f},
+    { 0.6f, 0, 0}, { 0.2f, 0, 0.2f}, { 0.2f, 0, -0.2f}
+};
+
+// Red triangle
+static const float basicShape[3][3] = {
+    {0, 0.4f, 0}, {-0.4f, -0.4f, 0}, {0.4f, -0.4f, 0}
+};
+
+// Purple diamond
+static const float zigzagShape[6][3] = {
+    {0, 0.4f, 0}, {-0.3f, 0, 0}, {0, -0.4f, 0},
+    {0, 0.4f, 0}, {0, -0.4f, 0}, {0.3f, 0, 0}
+};
+
+// Green X shape, one diagonal bar per pair of triangles
+static const float circlerShape[12][3] = {
+    {-0.4f, -0.4f, 0}, {-0.2f, -0.2f, 0}, { 0.4f,  0.4f, 0},
+    {-0.2f, -0.2f, 0}, { 0.4f,  0.4f, 0}, { 0.2f,  0.2f, 0},
+    { 0.4f, -0.4f, 0}, { 0.2f, -0.2f, 0}, {-0.4f,  0.4f, 0},
+    { 0.2f, -0.2f, 0}, {-0.4f,  0.4f, 0}, {-0.2f,  0.2f, 0}
+};
+
+// Orange square, then a white center triangle and small dot
+static const float shooterSquareShape[6][3] = {
+    {-0.3f, 0.3f, 0}, {0.3f, 0.3f, 0}, {0.3f, -0.3f, 0},
+    {-0.3f, 0.3f, 0}, {0.3f, -0.3f, 0}, {-0.3f, -0.3f, 0}
+};
+static const float shooterCenterShape[6][3] = {
+    {0, 0.2f, 0}, {-0.15f, -0.1f, 0}, {0.15f, -0.1f, 0},
+    {0, 0, 0.05f}, {0.05f, 0, 0}, {0, 0.05f, 0}
+};
+
+// Blue hexagon as a fan of six triangles
+static const float tankShape[18][3] = {
+    {0, 0, 0}, {0, 0.5f, 0}, {0.4f, 0.25f, 0},
+    {0, 0, 0}, {0.4f, 0.25f, 0}, {0.4f, -0.25f, 0},
+    {0, 0, 0}, {0.4f, -0.25f, 0}, {0, -0.5f, 0},
+    {0, 0, 0}, {0, -0.5f, 0}, {-0.4f, -0.25f, 0},
+    {0, 0, 0}, {-0.4f, -0.25f, 0}, {-0.4f, 0.25f, 0},
+    {0, 0, 0}, {-0.4f, 0.25f, 0}, {0, 0.5f, 0}
+};
+
+// Yellow star from three triangles
+static const float speedsterShape[9][3] = {
+    {0, 0.35f, 0}, {-0.1f, 0.05f, 0}, {0.1f, 0.05f, 0},
+    {-0.3f, -0.2f, 0}, {-0.05f, -0.05f, 0}, {0, 0, 0},
+    {0.3f, -0.2f, 0}, {0, 0, 0}, {0.05f, -0.05f, 0}
+};
+
+typedef struct {
+    struct Vertex* out;
+    int capacity;
+    int count;
+    MeshRange* ranges;
+} Baker;
+
+// Start a new mesh at the end of the vertices baked so far
+static void beginMesh(Baker* b, MeshId id) {
+    b->ranges[id].first = (unsigned short)b->count;
+    b->ranges[id].count = 0;
+}
+
+// Append triangles to the mesh most recently started with beginMesh()
+static void addMeshVertices(Baker* b, MeshId id, unsigned int color, const float (*shape)[3], int count) {
+    for(int i = 0; i < count; i++) {
+        if(b->count < b->capacity) {
+            struct Vertex* v = &b->out[b->count];
+            v->color = color;
+            v->x = shape[i][0];
+            v->y = shape[i][1];
+            v->z = shape[i][2];
+        }
+        b->count++;
+    }
+    b->ranges[id].count += count;
+}
+
+static void buildMesh(Baker* b, MeshId id, unsigned int color, const float (*shape)[3], int count) {
+    beginMesh(b, id);
+    addMeshVertices(b, id, color, shape, count);
+}
+
+int meshBake(struct Vertex* out, int capacity, MeshRange ranges[MESH_COUNT]) {
+    Baker b = {out, capacity, 0, ranges};
+
+    buildMesh(&b, MESH_CUBE_WHITE, 0xFFDDDDDD, cubeShape, 36);
+    buildMesh(&b, MESH_CUBE_YELLOW, 0xFF00FFFF, cubeShape, 36);
+    buildMesh(&b, MESH_CUBE_BLUE, 0xFFFF0000, cubeShape, 36);
+    buildMesh(&b, MESH_PLAYER_WINGS, 0xFF0080FF, wingsShape, 6);
+
+    buildMesh(&b, MESH_ENEMY_BASIC, 0xFF0000FF, basicShape, 3);
+    buildMesh(&b, MESH_ENEMY_ZIGZAG, 0xFFFF00FF, zigzagShape, 6);
+    buildMesh(&b, MESH_ENEMY_CIRCLER, 0xFF00FF00, circlerShape, 12);
+    beginMesh(&b, MESH_ENEMY_SHOOTER);
+    addMeshVertices(&b, MESH_ENEMY_SHOOTER, 0xFF0088FF, shooterSquareShape, 6);
+    addMeshVertices(&b, MESH_ENEMY_SHOOTER, 0xFFFFFFFF, shooterCenterShape, 6);
+    buildMesh(&b, MESH_ENEMY_TANK, 0xFFFFAA00, tankShape, 18);
+    buildMesh(&b, MESH_ENEMY_SPEEDSTER, 0xFF00FFFF, speedsterShape, 9);
+
+    return b.count <= capacity ? b.count : -1;
+}
+
+float meshRadius(MeshId first, MeshId last) {
+    static struct Vertex baked[MESH_VERTEX_CAPACITY];   // Off the stack; called once per user
+    MeshRange ranges[MESH_COUNT];
+    meshBake(baked, MESH_VERTEX_CAPACITY, ranges);
+
+    float radius = 0;
+    for(int id = first; id <= last; id++) {
+        for(int i = ranges[id].first; i < ranges[id].first + ranges[id].count; i++) {
+            const struct Vertex* v = &baked[i];
+            float r = sqrtf(v->x * v->x + v->y * v->y + v->z * v->z);
+            if(r > radius) radius = r;
+        }
+    }
+    return radius + MESH_POSITION_SCALE / 32768.0f;
+}
+
+short meshQuantize(float v, float scale) {
+    float q = v / scale * 32768.0f;
+    if(q >= 32767.0f) return 32767;
+    if(q <= -32768.0f) return -32768;
+    return (short)(q < 0 ? q - 0.5f : q + 0.5f);
+}
+
+// Each channel rounded to the nearest of the narrower levels
+static unsigned int narrow(unsigned int channel, unsigned int levels) {
+    return (channel * levels + 127) / 255;
+}
+
+unsigned short meshColor5650(unsigned int color) {
+    unsigned int r = color & 0xFF, g = (color >> 8) & 0xFF, b = (color >> 16) & 0xFF;
+    return (unsigned short)(narrow(r, 31) | narrow(g, 63) << 5 | narrow(b, 31) << 11);
+}
+
+unsigned short meshColor4444(unsigned int color) {
+    unsigned int r = color & 0xFF, g = (color >> 8) & 0xFF, b = (color >> 16) & 0xFF, a = color >> 24;
+    return (unsigned short)(narrow(r, 15) | narrow(g, 15) << 4 | narrow(b, 15) << 8 | narrow(a, 15) << 12);
+}
+
+static int clamped(float v, float scale) {
+    float q = v / scale * 32768.0f;
+    return q > 32767.5f || q < -32768.5f;
+}
+
+int meshPack(const struct Vertex* in, struct PackedVertex* out, int count, float scale) {
+    int clamps = 0;
+    for(int i = 0; i < count; i++) {
+        out[i].color = meshColor5650(in[i].color);
+        out[i].x = meshQuantize(in[i].x, scale);
+        out[i].y = meshQuantize(in[i].y, scale);
+        out[i].z = meshQuantize(in[i].z, scale);
+        clamps += clamped(in[i].x, scale) + clamped(in[i].y, scale) + clamped(in[i].z, scale);
+    }
+    return clamps;
+}
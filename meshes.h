@@ -0,0 +1,62 @@
+// Static meshes: the shapes every entity is drawn with, baked into one vertex
+// array. The asset packer bakes them into the archive; the renderer points the
+// GE straight at that, and only bakes them itself when the archive has none.
+// Shapes are authored as float Vertex and drawn as PackedVertex: 5650 color and
+// 16-bit positions, which the model matrix scales back up
+#ifndef MESHES_H
+#define MESHES_H
+
+struct Vertex {
+    unsigned int color;
+    float x, y, z;
+};
+
+// Half the size of a Vertex. A 16-bit position p stands for p / 32768 * scale,
+// the scale applied by the model matrix
+struct PackedVertex {
+    unsigned short color;
+    short x, y, z;
+};
+
+// Packed mesh positions cover [-2, 2): every shape fits with room to spare,
+// and 1.0 and the other steps of 1/16384 come out exact
+#define MESH_POSITION_SCALE 2.0f
+
+typedef enum {
+    MESH_CUBE_WHITE,
+    MESH_CUBE_YELLOW,
+    MESH_CUBE_BLUE,
+    MESH_PLAYER_WINGS,
+    MESH_ENEMY_BASIC,      // One mesh per EnemyType, in EnemyType order
+    MESH_ENEMY_ZIGZAG,
+    MESH_ENEMY_CIRCLER,
+    MESH_ENEMY_SHOOTER,
+    MESH_ENEMY_TANK,
+    MESH_ENEMY_SPEEDSTER,
+    MESH_COUNT
+} MeshId;
+
+#define MESH_VERTEX_CAPACITY 256
+
+// Where one mesh sits in the baked vertex array
+typedef struct {
+    unsigned short first;
+    unsigned short count;
+} MeshRange;
+
+// Bake every mesh into out. Returns the vertex count, or -1 if they do not fit
+int meshBake(struct Vertex* out, int capacity, MeshRange ranges[MESH_COUNT]);
+
+// Furthest any vertex of meshes first..last gets from the mesh origin, packed
+// rounding included
+float meshRadius(MeshId first, MeshId last);
+
+// A coordinate as a 16-bit fraction of scale, rounded; out of range clamps
+short meshQuantize(float v, float scale);
+// An 8888 color (0xAABBGGRR) with alpha dropped, or kept in four bits
+unsigned short meshColor5650(unsigned int color);
+unsigned short meshColor4444(unsigned int color);
+// Pack vertices at a uniform scale. Returns how many coordinates were clamped
+int meshPack(const struct Vertex* in, struct PackedVertex* out, int count, float scale);
+
+#endif
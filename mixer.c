@@ -0,0 +1,182 @@
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "mixer.h"
+#include "platform.h"
+
+typedef struct {
+    const short* data;
+    int frames;
+    int position;
+    int priority;
+    float gain;
+    short channelGain[2];   // Q15, left and right after panning
+    int active;
+} Voice;
+
+static Voice voices[MIXER_VOICES];
+static MixerStats stats;
+
+// Stereo accumulator for one block. 16-byte aligned and filled in multiples of
+// 8 samples, so it suits SSE2/NEON here and a VFPU-sized layout on the PSP
+static int __attribute__((aligned(16))) accumulator[AUDIO_MAX_BLOCK_SAMPLES * 2];
+
+void mixerInit(void) {
+    memset(voices, 0, sizeof(voices));
+    memset(&stats, 0, sizeof(stats));
+}
+
+static short toQ15(float gain) {
+    if(gain <= 0.0f) return 0;
+    if(gain >= 1.0f) return 32767;
+    return (short)(gain * 32767.0f);
+}
+
+// Centre is full gain on both sides; panning only attenuates the far side
+static void setVoicePan(Voice* v, float pan) {
+    v->channelGain[0] = toQ15(v->gain * (pan > 0.0f ? 1.0f - pan : 1.0f));
+    v->channelGain[1] = toQ15(v->gain * (pan < 0.0f ? 1.0f + pan : 1.0f));
+}
+
+int mixerPlay(const Sample* sample, float gain, float pan, int priority) {
+    if(!sample->data || sample->frames <= 0) return -1;
+
+    // A free voice, or else the lowest-priority one, the furthest along
+    // among equals
+    int slot = -1;
+    for(int i = 0; i < MIXER_VOICES; i++) {
+        if(!voices[i].active) { slot = i; break; }
+        if(slot < 0 || voices[i].priority < voices[slot].priority ||
+           (voices[i].priority == voices[slot].priority && voices[i].position > voices[slot].position)) {
+            slot = i;
+        }
+    }
+    Voice* v = &voices[slot];
+    if(v->active) {
+        if(v->priority > priority) {
+            __atomic_store_n(&stats.dropped, stats.dropped + 1, __ATOMIC_RELAXED);
+            return -1;
+        }
+        __atomic_store_n(&stats.stolen, stats.stolen + 1, __ATOMIC_RELAXED);
+        v->active = 0;
+    }
+
+    v->data = sample->data;
+    v->frames = sample->frames;
+    v->position = 0;
+    v->priority = priority;
+    v->gain = gain;
+    setVoicePan(v, pan);
+    v->active = 1;
+    return slot;
+}
+
+void mixerStop(const Sample* sample) {
+    for(int i = 0; i < MIXER_VOICES; i++)
+        if(voices[i].active && voices[i].data == sample->data) voices[i].active = 0;
+}
+
+void mixerSetPan(const Sample* sample, float pan) {
+    for(int i = 0; i < MIXER_VOICES; i++)
+        if(voices[i].active && voices[i].data == sample->data) setVoicePan(&voices[i], pan);
+}
+
+// accumulator += (src * gain) >> 15 over count interleaved samples
+static void mixVoice(int* acc, const short* src, int count, const short gain[2]) {
+    int i = 0;
+#if defined(__SSE2__)
+    __m128i g = _mm_set_epi16(gain[1], gain[0], gain[1], gain[0], gain[1], gain[0], gain[1], gain[0]);
+    for(; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_mullo_epi16(s, g);
+        __m128i hi = _mm_mulhi_epi16(s, g);
+        __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15);
+        __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15);
+        __m128i* a = (__m128i*)(acc + i);
+        _mm_store_si128(a, _mm_add_epi32(_mm_load_si128(a), p0));
+        _mm_store_si128(a + 1, _mm_add_epi32(_mm_load_si128(a + 1), p1));
+    }
+#elif defined(__ARM_NEON)
+    const short pair[4] = {gain[0], gain[1], gain[0], gain[1]};
+    int16x4_t g = vld1_s16(pair);
+    for(; i + 8 <= count; i += 8) {
+        int16x8_t s = vld1q_s16(src + i);
+        int32x4_t p0 = vshrq_n_s32(vmull_s16(vget_low_s16(s), g), 15);
+        int32x4_t p1 = vshrq_n_s32(vmull_s16(vget_high_s16(s), g), 15);
+        vst1q_s32(acc + i, vaddq_s32(vld1q_s32(acc + i), p0));
+        vst1q_s32(acc + i + 4, vaddq_s32(vld1q_s32(acc + i + 4), p1));
+    }
+#endif
+    for(; i < count; i++) acc[i] += (src[i] * gain[i & 1]) >> 15;
+}
+
+// 32 voices of full-scale 16-bit audio stay far inside int32, so the clamp
+// happens once here rather than after every voice
+static void saturate(short* out, const int* acc, int count) {
+    int i = 0;
+#if defined(__SSE2__)
+    for(; i + 8 <= count; i += 8) {
+        __m128i a0 = _mm_load_si128((const __m128i*)(acc + i));
+        __m128i a1 = _mm_load_si128((const __m128i*)(acc + i + 4));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a0, a1));
+    }
+#elif defined(__ARM_NEON)
+    for(; i + 8 <= count; i += 8) {
+        int16x8_t s = vcombine_s16(vqmovn_s32(vld1q_s32(acc + i)), vqmovn_s32(vld1q_s32(acc + i + 4)));
+        vst1q_s16(out + i, s);
+    }
+#endif
+    for(; i < count; i++) {
+        int v = acc[i];
+        out[i] = (short)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+    }
+}
+
+static void renderBlock(short* out, const short* music, int frames) {
+    int count = frames * 2;
+    if(music) {
+        for(int i = 0; i < count; i++) accumulator[i] = music[i];
+    } else {
+        memset(accumulator, 0, count * sizeof(int));
+    }
+
+    int active = 0;
+    for(int i = 0; i < MIXER_VOICES; i++) {
+        Voice* v = &voices[i];
+        if(!v->active) continue;
+
+        int n = v->frames - v->position;
+        if(n > frames) n = frames;
+        mixVoice(accumulator, v->data + v->position * 2, n * 2, v->channelGain);
+        v->position += n;
+        if(v->position >= v->frames) v->active = 0;
+        active++;
+    }
+    __atomic_store_n(&stats.active, active, __ATOMIC_RELAXED);
+    if(active > stats.peak) __atomic_store_n(&stats.peak, active, __ATOMIC_RELAXED);
+
+    saturate(out, accumulator, count);
+}
+
+void mixerRender(short* out, const short* music, int frames) {
+    while(frames > 0) {
+        int n = frames < AUDIO_MAX_BLOCK_SAMPLES ? frames : AUDIO_MAX_BLOCK_SAMPLES;
+        renderBlock(out, music, n);
+        out += n * 2;
+        if(music) music += n * 2;
+        frames -= n;
+    }
+}
+
+// Counters are only written by the audio thread; other threads take a copy
+void mixerStats(MixerStats* out) {
+    out->active = __atomic_load_n(&stats.active, __ATOMIC_RELAXED);
+    out->peak = __atomic_load_n(&stats.peak, __ATOMIC_RELAXED);
+    out->stolen = __atomic_load_n(&stats.stolen, __ATOMIC_RELAXED);
+    out->dropped = __atomic_load_n(&stats.dropped, __ATOMIC_RELAXED);
+}
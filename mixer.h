@@ -0,0 +1,34 @@
+// Software mixer: MIXER_VOICES one-shot voices summed over the music in a
+// 32-bit accumulator and saturated to 16-bit once per block. When every voice
+// is busy a new sound takes the lowest-priority voice, or is dropped if all
+// of them outrank it. Only the audio thread calls into the mixer; other
+// threads go through the audio command queue
+#ifndef MIXER_H
+#define MIXER_H
+
+#define MIXER_VOICES 32
+
+// Interleaved 16-bit stereo PCM
+typedef struct {
+    const short* data;
+    int frames;
+} Sample;
+
+typedef struct {
+    int active;      // Voices mixed into the last block
+    int peak;        // Most voices ever playing at once
+    int stolen;      // Voices cut off for a higher-priority sound
+    int dropped;     // Sounds refused because every voice outranked them
+} MixerStats;
+
+void mixerInit(void);
+// gain 0..1, pan -1 (left) .. 1 (right). Returns the voice, or -1 if dropped
+int mixerPlay(const Sample* sample, float gain, float pan, int priority);
+// Stop, or re-pan, every voice playing a sample
+void mixerStop(const Sample* sample);
+void mixerSetPan(const Sample* sample, float pan);
+// Mix every active voice over music (NULL for silence) into frames of output
+void mixerRender(short* out, const short* music, int frames);
+void mixerStats(MixerStats* out);
+
+#endif
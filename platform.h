@@ -0,0 +1,114 @@
+// Platform layer: the only things the game needs from the machine it runs on.
+// game.c, audio.c and main.c talk to these functions; platform_psp.c and
+// render_psp.c implement them on the PSP, platform_linux.c implements them
+// headless for benchmarking and testing on a desktop
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdint.h>
+#include "game.h"
+
+// Buttons, with the same bits as the PSP controller
+#define BUTTON_SELECT   0x000001
+#define BUTTON_START    0x000008
+#define BUTTON_UP       0x000010
+#define BUTTON_RIGHT    0x000020
+#define BUTTON_DOWN     0x000040
+#define BUTTON_LEFT     0x000080
+#define BUTTON_RTRIGGER 0x000200
+#define BUTTON_TRIANGLE 0x001000
+#define BUTTON_CROSS    0x004000
+
+// Samples per channel in one audio output block (stereo, 16-bit, 44.1kHz).
+// The size is picked at startup: smaller blocks start sound effects sooner
+// but wake the audio thread more often. The PSP wants a multiple of 64
+#define AUDIO_MIN_BLOCK_SAMPLES 64
+#define AUDIO_MAX_BLOCK_SAMPLES 2048
+#define AUDIO_DEFAULT_BLOCK_SAMPLES 512
+#define AUDIO_SAMPLE_RATE 44100
+
+// Thread priorities, in PSP terms (lower runs first). Ignored on Linux
+#define THREAD_PRIORITY_AUDIO 0x12
+#define THREAD_PRIORITY_DECODER 0x16   // Below audio output, above the game loop
+#define THREAD_PRIORITY_LOADER 0x30    // Below the game loop: runs while it waits for vblank
+
+typedef int (*PlatformThreadFunc)(void* arg);
+
+// Groups of figures the debug overlay pages through with R, the last showing
+// only its status line
+typedef enum {
+    OVERLAY_FRAME,
+    OVERLAY_RENDER,
+    OVERLAY_AUDIO,
+    OVERLAY_OFF,
+    OVERLAY_PAGES
+} OverlayPage;
+
+// Per-frame figures the main loop hands to the renderer for the overlay
+typedef struct {
+    float fps;
+    int ticks;          // Simulation ticks run this frame
+    int droppedTicks;   // Ticks discarded by the catch-up cap so far
+    size_t arenaSize;
+    unsigned int firstFrameUs;     // From startup to the first frame on screen
+    unsigned int interactiveUs;    // From startup to the game taking input
+    int inputEdge;                 // This frame is the first to act on a button edge...
+    uint64_t inputEdgeUs;          // ...seen at this wall time
+    int lateLatch;                 // Re-read the pad for the player and camera before drawing
+    int latched;                   // The late latch placed the player this frame...
+    float latchedX, latchedY;      // ...here, instead of between the last two ticks
+    OverlayPage overlayPage;
+} FrameInfo;
+
+// Lifecycle. platformInit may override settings (Linux reads the command line)
+int platformInit(int argc, char** argv, Settings* settings);
+void platformShutdown(void);
+void platformFatal(const char* message);
+void platformLog(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+// Time and input. platformTimeUs is the clock the game loop runs on, which
+// is virtual on headless runs; platformWallTimeUs is always real time.
+// platformReadButtons peeks at the pad's latest sample without waiting
+uint64_t platformTimeUs(void);
+uint64_t platformWallTimeUs(void);
+void platformSleepUs(unsigned int us);
+unsigned int platformReadButtons(void);
+
+// Threads
+int platformStartThread(const char* name, PlatformThreadFunc func, void* arg, int priority, int stackSize);
+
+// Files, read-only. Handles are negative on failure; whence is SEEK_SET/CUR/END
+int platformFileOpen(const char* path);
+int platformFileRead(int fd, void* buffer, int size);
+long platformFileSeek(int fd, long offset, int whence);
+void platformFileClose(int fd);
+// Asynchronous read of size bytes at offset, one in flight per file.
+// platformFileWait blocks until it is done and returns the bytes read, or -1.
+// platformFileReady says whether that would block. A poll that finds the read
+// done consumes its result, so a read is always collected with
+// platformFileWait, which then returns the kept result at once
+int platformFileReadAsync(int fd, long offset, void* buffer, int size);
+int platformFileReady(int fd);
+int platformFileWait(int fd);
+// Read-only view of a file's first size bytes, 64-byte aligned: mapped on
+// Linux, read in one call into one allocation on the PSP. The view outlives
+// the handle. NULL on failure
+const void* platformFileMap(int fd, long size);
+void platformFileUnmap(const void* data, long size);
+
+// Audio output: one stereo channel of blockSamples blocks. Output blocks
+// until the hardware has room, which paces the audio thread
+int platformAudioOpen(int blockSamples);
+void platformAudioOutput(const short* buffer);
+
+// Rendering. renderFrame draws the game blended alpha of the way from the
+// previous tick to the current one, then waits for vblank and presents
+void renderInit(void);
+// Startup: loading screen frames until the must-have assets are in, then
+// renderAssetsReady once before the first renderFrame
+void renderLoading(float progress, const char* stage);
+void renderAssetsReady(void);
+void renderFrame(const Game* g, float alpha, const FrameInfo* frame);
+void renderShutdown(void);
+
+#endif
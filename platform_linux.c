@@ -0,0 +1,388 @@
+// Headless Linux backend: no window, no sound card. A scripted pad plays the
+// game and the renderer only counts frames, so the simulation core can be
+// run, benchmarked and checked on an ordinary desktop.
+//
+//   ./psp-game-linux [--frames N] [--realtime] [--no-audio] [--audio-block N]
+//                    [--late-latch] [--seed N] [--record FILE [--hash]] [--replay FILE]
+//                    [--profile FILE] [--bench-mixer] [--bench-collision] [--bench-movement]
+//                    [--stress-audio-queue] [--check-culling] [--check-meshes] [--check-terrain]
+//
+// By default the clock is virtual and advances one 60Hz refresh per frame, so
+// the loop runs as fast as the CPU allows while the game still sees exactly
+// one tick per frame. --realtime paces frames to the wall clock instead.
+// --late-latch turns on the main loop's late input latch, as late_latch = 1
+// does in the config file.
+// --record saves the session as a replay on exit (--hash adds per-tick state
+// hashes); --replay plays one back at full speed and checks the hashes.
+// --profile writes the frame profiler's CSV on exit. The --bench-* and
+// --check-* flags run one of the host checks in tests/host_checks.c instead
+// of the game and exit with its status
+#define _GNU_SOURCE
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "platform.h"
+#include "mixer.h"
+#include "audio.h"
+#include "cull.h"
+#include "tests/host_checks.h"
+
+#define FRAME_US 16667
+
+static struct {
+    int maxFrames;
+    int realtime;
+    int audio;
+} options = {3600, 0, 1};
+
+static uint64_t startUs;
+static uint64_t virtualUs;
+static int frames;
+static int loadingFrames;
+static long long totalTicks;
+static const Game* lastGame;
+static FrameInfo lastFrame;
+static CullStats lastCulled;
+static long long culledTotal, drawnTotal;
+// Input edge to the frame answering it being shown. As on the PSP, a frame
+// goes up at the vblank that ends the next one
+static int shownEdge;
+static uint64_t shownEdgeUs;
+static struct {
+    unsigned int count;
+    unsigned int maxUs;
+    unsigned long long sumUs;
+} inputLatency;
+
+uint64_t platformWallTimeUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+static void copyPath(char* dst, size_t size, const char* src) {
+    snprintf(dst, size, "%s", src);
+}
+
+int platformInit(int argc, char** argv, Settings* settings) {
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) options.maxFrames = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--realtime") == 0) options.realtime = 1;
+        else if(strcmp(argv[i], "--no-audio") == 0) options.audio = 0;
+        else if(strcmp(argv[i], "--audio-block") == 0 && i + 1 < argc) settings->audioBlockSamples = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--late-latch") == 0) settings->lateLatch = 1;
+        else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc) settings->seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "--record") == 0 && i + 1 < argc) copyPath(settings->recordPath, sizeof(settings->recordPath), argv[++i]);
+        else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc) copyPath(settings->replayPath, sizeof(settings->replayPath), argv[++i]);
+        else if(strcmp(argv[i], "--hash") == 0) settings->hashTicks = 1;
+        else if(strcmp(argv[i], "--profile") == 0 && i + 1 < argc) copyPath(settings->profilePath, sizeof(settings->profilePath), argv[++i]);
+        else {
+            int status = hostCheckRun(argv[i]);
+            if(status >= 0) exit(status);
+            fprintf(stderr, "usage: %s [--frames N] [--realtime] [--no-audio] [--audio-block N]\n"
+                            "       [--late-latch] [--seed N] [--record FILE [--hash]] [--replay FILE]\n"
+                            "       [--profile FILE] [--bench-mixer] [--bench-collision] [--bench-movement]\n"
+                            "       [--stress-audio-queue] [--check-culling] [--check-meshes] [--check-terrain]\n", argv[0]);
+            return -1;
+        }
+    }
+    startUs = platformWallTimeUs();
+    return 0;
+}
+
+void platformShutdown(void) {
+    if(frames == 0) return;  // Replay playback reports for itself
+    double wall = (platformWallTimeUs() - startUs) / 1000000.0;
+    printf("frames: %d  ticks: %lld  dropped: %d\n", frames, totalTicks, lastFrame.droppedTicks);
+    printf("wall: %.3f s  %.1f frames/s\n", wall, wall > 0 ? frames / wall : 0.0);
+    printf("startup: first frame %.2f ms  interactive %.2f ms  (%d loading frames)\n",
+           lastFrame.firstFrameUs / 1000.0, lastFrame.interactiveUs / 1000.0, loadingFrames);
+    printf("input latency: %.1f ms avg  %.1f ms max over %u edges  (late latch %s)\n",
+           inputLatency.count ? inputLatency.sumUs / 1000.0 / inputLatency.count : 0.0,
+           inputLatency.maxUs / 1000.0, inputLatency.count, lastFrame.lateLatch ? "on" : "off");
+    if(lastGame) {
+        int enemies, bullets, eBullets, particles;
+        countEntities(lastGame, &enemies, &bullets, &eBullets, &particles);
+        printf("score: %d  health: %d  time: %.2f s\n", lastGame->score, lastGame->player.health, lastGame->time);
+        printf("live: %d enemies %d bullets %d enemy bullets %d particles\n", enemies, bullets, eBullets, particles);
+        printf("culled: %d enemies %d bullets %d enemy bullets %d particles  (%.1f%% of entity draws over the run)\n",
+               lastCulled.enemies, lastCulled.bullets, lastCulled.enemyBullets, lastCulled.particles,
+               drawnTotal + culledTotal ? 100.0 * culledTotal / (drawnTotal + culledTotal) : 0.0);
+    }
+    if(options.audio) {
+        MixerStats mixer;
+        mixerStats(&mixer);
+        printf("audio: peak %d voices  %d stolen  %d dropped  %u commands lost\n",
+               mixer.peak, mixer.stolen, mixer.dropped, audioCommandOverflows());
+        MusicStats music;
+        musicStats(&music);
+        printf("music: %u underruns (%u frames)  lowest %u of %u frames buffered\n",
+               music.underruns, music.missingFrames, music.minBufferedFrames, music.bufferFrames);
+        printf("music io: %u file reads for %u decoder reads  %u of %u seeks buffered  %u stalls %.1f ms\n",
+               music.io.fileReads, music.io.requests, music.io.seeksBuffered, music.io.seeks,
+               music.io.stalls, music.io.stallUs / 1000.0);
+        AudioStats audio;
+        audioStats(&audio);
+        printf("sfx latency: %.1f ms avg  %.1f ms max over %u sounds  (%d-sample blocks)\n",
+               audio.latencyAvgUs / 1000.0, audio.latencyMaxUs / 1000.0, audio.sounds, audio.blockSamples);
+        printf("audio thread: %u wakeups  %.1f/s  %.2f%% busy\n", audio.blocks,
+               (double)AUDIO_SAMPLE_RATE / audio.blockSamples, audio.busyBasisPoints / 100.0);
+    }
+}
+
+void platformFatal(const char* message) {
+    fprintf(stderr, "%s\n", message);
+    exit(1);
+}
+
+void platformLog(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+uint64_t platformTimeUs(void) {
+    return options.realtime ? platformWallTimeUs() : virtualUs;
+}
+
+void platformSleepUs(unsigned int us) {
+    usleep(us);
+}
+
+// Scripted pad: weave across the field, tap fire every few frames (which also
+// restarts after a game over) and press START once the frame budget is spent
+unsigned int platformReadButtons(void) {
+    if(frames >= options.maxFrames) return BUTTON_START;
+
+    unsigned int buttons = 0;
+    buttons |= (frames / 90) % 2 ? BUTTON_LEFT : BUTTON_RIGHT;
+    if((frames / 150) % 3 == 1) buttons |= BUTTON_UP;
+    if((frames / 150) % 3 == 2) buttons |= BUTTON_DOWN;
+    if(frames % 10 < 5) buttons |= BUTTON_CROSS;
+    return buttons;
+}
+
+typedef struct {
+    PlatformThreadFunc func;
+    void* arg;
+} ThreadStart;
+
+static void* threadEntry(void* p) {
+    ThreadStart start = *(ThreadStart*)p;
+    free(p);
+    start.func(start.arg);
+    return NULL;
+}
+
+int platformStartThread(const char* name, PlatformThreadFunc func, void* arg, int priority, int stackSize) {
+    ThreadStart* start = (ThreadStart*)malloc(sizeof(ThreadStart));
+    if(!start) return -1;
+    start->func = func;
+    start->arg = arg;
+
+    pthread_t thread;
+    if(pthread_create(&thread, NULL, threadEntry, start) != 0) {
+        free(start);
+        return -1;
+    }
+    pthread_setname_np(thread, name);
+    pthread_detach(thread);
+    return 0;
+}
+
+int platformFileOpen(const char* path) {
+    return open(path, O_RDONLY);
+}
+
+int platformFileRead(int fd, void* buffer, int size) {
+    return (int)read(fd, buffer, size);
+}
+
+long platformFileSeek(int fd, long offset, int whence) {
+    return (long)lseek(fd, offset, whence);
+}
+
+void platformFileClose(int fd) {
+    close(fd);
+}
+
+// Asynchronous reads: a pread worker thread works through a few request
+// slots, each owned by the file that queued it until the result is collected
+#define FILE_READ_SLOTS 4
+
+typedef struct {
+    int fd;              // -1 when the slot is free
+    long offset;
+    void* buffer;
+    int size;
+    int done;
+    int result;
+} FileRead;
+
+static FileRead fileReads[FILE_READ_SLOTS] = {{-1}, {-1}, {-1}, {-1}};
+static pthread_mutex_t fileReadLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fileReadChanged = PTHREAD_COND_INITIALIZER;
+static int fileReaderStarted;
+
+static void* fileReader(void* arg) {
+    pthread_mutex_lock(&fileReadLock);
+    for(;;) {
+        FileRead* r = NULL;
+        for(int i = 0; i < FILE_READ_SLOTS && !r; i++)
+            if(fileReads[i].fd >= 0 && !fileReads[i].done) r = &fileReads[i];
+        if(!r) {
+            pthread_cond_wait(&fileReadChanged, &fileReadLock);
+            continue;
+        }
+
+        FileRead request = *r;
+        pthread_mutex_unlock(&fileReadLock);
+        int result = (int)pread(request.fd, request.buffer, request.size, request.offset);
+        pthread_mutex_lock(&fileReadLock);
+        r->result = result;
+        r->done = 1;
+        pthread_cond_broadcast(&fileReadChanged);
+    }
+    return NULL;
+}
+
+int platformFileReadAsync(int fd, long offset, void* buffer, int size) {
+    pthread_mutex_lock(&fileReadLock);
+    if(!fileReaderStarted) {
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, fileReader, NULL) != 0) {
+            pthread_mutex_unlock(&fileReadLock);
+            return -1;
+        }
+        pthread_setname_np(thread, "file_reader");
+        pthread_detach(thread);
+        fileReaderStarted = 1;
+    }
+
+    FileRead* r = NULL;
+    for(int i = 0; i < FILE_READ_SLOTS && !r; i++)
+        if(fileReads[i].fd < 0) r = &fileReads[i];
+    if(r) {
+        r->fd = fd;
+        r->offset = offset;
+        r->buffer = buffer;
+        r->size = size;
+        r->done = 0;
+        pthread_cond_broadcast(&fileReadChanged);
+    }
+    pthread_mutex_unlock(&fileReadLock);
+    return r ? 0 : -1;
+}
+
+int platformFileReady(int fd) {
+    int ready = 1;
+    pthread_mutex_lock(&fileReadLock);
+    for(int i = 0; i < FILE_READ_SLOTS; i++)
+        if(fileReads[i].fd == fd) ready = fileReads[i].done;
+    pthread_mutex_unlock(&fileReadLock);
+    return ready;
+}
+
+int platformFileWait(int fd) {
+    int result = -1;
+    pthread_mutex_lock(&fileReadLock);
+    for(int i = 0; i < FILE_READ_SLOTS; i++) {
+        if(fileReads[i].fd != fd) continue;
+        while(!fileReads[i].done) pthread_cond_wait(&fileReadChanged, &fileReadLock);
+        result = fileReads[i].result;
+        fileReads[i].fd = -1;
+        break;
+    }
+    pthread_mutex_unlock(&fileReadLock);
+    return result;
+}
+
+const void* platformFileMap(int fd, long size) {
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    return data == MAP_FAILED ? NULL : data;
+}
+
+void platformFileUnmap(const void* data, long size) {
+    munmap((void*)data, size);
+}
+
+// Null sink: a device clock that plays one block every blockUs. Output waits
+// for the previous block's slot, like a hardware channel with one queued buffer
+static uint64_t audioBlockUs;
+static uint64_t audioDeadline;
+
+int platformAudioOpen(int blockSamples) {
+    if(!options.audio) return -1;
+    audioBlockUs = (uint64_t)blockSamples * 1000000ull / AUDIO_SAMPLE_RATE;
+    return 0;
+}
+
+void platformAudioOutput(const short* buffer) {
+    uint64_t now = platformWallTimeUs();
+    if(audioDeadline < now) audioDeadline = now;  // Underrun: the device was idle
+    if(audioDeadline > now) usleep(audioDeadline - now);
+    audioDeadline += audioBlockUs;
+}
+
+void renderInit(void) {
+}
+
+// A loading frame waits out a frame in real time; headless it only lets the
+// loader thread run
+void renderLoading(float progress, const char* stage) {
+    loadingFrames++;
+    if(options.realtime) usleep(FRAME_US);
+    else sched_yield();
+}
+
+void renderAssetsReady(void) {
+}
+
+// Nothing is drawn; a frame only advances the clock, standing in for vblank.
+// Culling is counted the way the PSP renderer would cull
+void renderFrame(const Game* g, float alpha, const FrameInfo* frame) {
+    lastGame = g;
+    lastFrame = *frame;
+    totalTicks += frame->ticks;
+    frames++;
+
+    const Player* p = &g->player;
+    Frustum view;
+    cameraFrustum(&view, p->prevX + (p->x - p->prevX) * alpha, p->prevY + (p->y - p->prevY) * alpha,
+                  p->prevZ + (p->z - p->prevZ) * alpha);
+    countCulled(g, &view, alpha, &lastCulled);
+    int enemies, bullets, eBullets, particles;
+    countEntities(g, &enemies, &bullets, &eBullets, &particles);
+    int culled = lastCulled.enemies + lastCulled.bullets + lastCulled.enemyBullets + lastCulled.particles;
+    culledTotal += culled;
+    drawnTotal += enemies + bullets + eBullets + particles - culled;
+
+    if(options.realtime) {
+        uint64_t next = startUs + (uint64_t)frames * FRAME_US;
+        uint64_t now = platformWallTimeUs();
+        if(next > now) usleep(next - now);
+    } else {
+        virtualUs += FRAME_US;
+    }
+
+    if(shownEdge) {
+        unsigned int us = (unsigned int)(platformWallTimeUs() - shownEdgeUs);
+        inputLatency.count++;
+        inputLatency.sumUs += us;
+        if(us > inputLatency.maxUs) inputLatency.maxUs = us;
+    }
+    shownEdge = frame->inputEdge;
+    shownEdgeUs = frame->inputEdgeUs;
+}
+
+void renderShutdown(void) {
+}
@@ -0,0 +1,195 @@
+#include <pspkernel.h>
+#include <pspdebug.h>
+#include <pspctrl.h>
+#include <psprtc.h>
+#include <pspaudio.h>
+#include <pspiofilemgr.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+
+#include "platform.h"
+
+PSP_MODULE_INFO("PSP 3D Shooter", 0, 1, 6);
+PSP_MAIN_THREAD_ATTR(THREAD_ATTR_USER | THREAD_ATTR_VFPU);
+
+static int audioChannel = -1;
+static u32 tickResolution;
+static u64 startTick;
+
+int exit_callback(int arg1, int arg2, void *common) {
+    sceKernelExitGame();
+    return 0;
+}
+
+int CallbackThread(SceSize args, void *argp) {
+    int cbid = sceKernelCreateCallback("Exit Callback", exit_callback, NULL);
+    sceKernelRegisterExitCallback(cbid);
+    sceKernelSleepThreadCB();
+    return 0;
+}
+
+int SetupCallbacks(void) {
+    int thid = sceKernelCreateThread("update_thread", CallbackThread, 0x11, 0xFA0, 0, 0);
+    if(thid >= 0) sceKernelStartThread(thid, 0, 0);
+    return thid;
+}
+
+int platformInit(int argc, char** argv, Settings* settings) {
+    SetupCallbacks();
+
+    sceCtrlSetSamplingCycle(0);
+    sceCtrlSetSamplingMode(PSP_CTRL_MODE_ANALOG);
+    tickResolution = sceRtcGetTickResolution();
+    sceRtcGetCurrentTick(&startTick);
+    return 0;
+}
+
+void platformShutdown(void) {
+    sceKernelExitGame();
+}
+
+// The HUD is drawn by the GE, so the debug screen is only brought up the
+// first time something is logged
+static void debugScreenPrint(const char* text) {
+    static int ready = 0;
+    if(!ready) {
+        pspDebugScreenInit();
+        ready = 1;
+    }
+    pspDebugScreenPrintf("%s", text);
+}
+
+// Leave the message on the debug screen until the user quits from the HOME menu
+void platformFatal(const char* message) {
+    debugScreenPrint(message);
+    sceKernelSleepThread();
+}
+
+void platformLog(const char* format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    debugScreenPrint(line);
+}
+
+// The RTC counts from year 1, so scaling the raw tick by a million would
+// overflow; measure from startup instead
+uint64_t platformTimeUs(void) {
+    u64 tick;
+    sceRtcGetCurrentTick(&tick);
+    return (tick - startTick) * 1000000ull / tickResolution;
+}
+
+uint64_t platformWallTimeUs(void) {
+    return platformTimeUs();
+}
+
+void platformSleepUs(unsigned int us) {
+    sceKernelDelayThread(us);
+}
+
+unsigned int platformReadButtons(void) {
+    SceCtrlData pad;
+    sceCtrlPeekBufferPositive(&pad, 1);
+    return pad.Buttons;
+}
+
+// Kernel threads take (size, argp) and copy argp onto the new thread's stack,
+// so the entry point and its argument travel together in one block
+typedef struct {
+    PlatformThreadFunc func;
+    void* arg;
+} ThreadStart;
+
+static int threadEntry(SceSize args, void* argp) {
+    ThreadStart* start = (ThreadStart*)argp;
+    return start->func(start->arg);
+}
+
+int platformStartThread(const char* name, PlatformThreadFunc func, void* arg, int priority, int stackSize) {
+    ThreadStart start = {func, arg};
+    SceUID thid = sceKernelCreateThread(name, threadEntry, priority, stackSize, 0, 0);
+    if(thid < 0) return -1;
+    sceKernelStartThread(thid, sizeof(start), &start);
+    return 0;
+}
+
+int platformFileOpen(const char* path) {
+    return sceIoOpen(path, PSP_O_RDONLY, 0777);
+}
+
+int platformFileRead(int fd, void* buffer, int size) {
+    return sceIoRead(fd, buffer, size);
+}
+
+long platformFileSeek(int fd, long offset, int whence) {
+    return (long)sceIoLseek(fd, (SceOff)offset, whence);
+}
+
+// sceIoPollAsync takes the result of a finished read, after which
+// sceIoWaitAsync has nothing left to wait for. A poll that finds the read
+// done keeps its result here for the platformFileWait that follows
+#define POLLED_FDS 64
+static struct {
+    int held;
+    SceInt64 result;
+} polled[POLLED_FDS];
+
+void platformFileClose(int fd) {
+    if(fd >= 0 && fd < POLLED_FDS) polled[fd].held = 0;
+    sceIoClose(fd);
+}
+
+int platformFileReadAsync(int fd, long offset, void* buffer, int size) {
+    if(sceIoLseek32(fd, (int)offset, PSP_SEEK_SET) < 0) return -1;
+    return sceIoReadAsync(fd, buffer, size);
+}
+
+int platformFileReady(int fd) {
+    // Without a slot to keep the result in, only the wait may collect it
+    if(fd < 0 || fd >= POLLED_FDS) return 0;
+    if(polled[fd].held) return 1;
+    SceInt64 result;
+    int status = sceIoPollAsync(fd, &result);
+    if(status == 1) return 0;
+    polled[fd].held = 1;
+    polled[fd].result = status < 0 ? -1 : result;
+    return 1;
+}
+
+int platformFileWait(int fd) {
+    if(fd >= 0 && fd < POLLED_FDS && polled[fd].held) {
+        polled[fd].held = 0;
+        return polled[fd].result < 0 ? -1 : (int)polled[fd].result;
+    }
+    SceInt64 result;
+    if(sceIoWaitAsync(fd, &result) < 0) return -1;
+    return (int)result;
+}
+
+const void* platformFileMap(int fd, long size) {
+    void* data = memalign(64, size);
+    if(!data) return NULL;
+    if(sceIoLseek32(fd, 0, PSP_SEEK_SET) < 0 || sceIoRead(fd, data, size) != size) {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+void platformFileUnmap(const void* data, long size) {
+    free((void*)data);
+}
+
+int platformAudioOpen(int blockSamples) {
+    audioChannel = sceAudioChReserve(-1, blockSamples, PSP_AUDIO_FORMAT_STEREO);
+    return audioChannel;
+}
+
+void platformAudioOutput(const short* buffer) {
+    sceAudioOutputBlocking(audioChannel, PSP_AUDIO_VOLUME_MAX, (void*)buffer);
+}
@@ -0,0 +1,110 @@
+#ifndef RELEASE
+
+#include <stdio.h>
+#include <string.h>
+
+#include "profiler.h"
+#include "platform.h"
+
+static const char* phaseNames[PHASE_COUNT] = {
+    "input", "spawn", "move", "collide", "particles",
+    "build", "gpu", "text", "vblank", "frame"
+};
+
+static struct {
+    uint64_t start[PHASE_COUNT];
+    unsigned int current[PHASE_COUNT];                   // This frame so far
+    unsigned int history[PROFILE_HISTORY][PHASE_COUNT];
+    int next;                                            // Ring write position
+    int count;                                           // Frames in the ring
+    int sinceRefresh;
+    PhaseStats stats[PHASE_COUNT];
+} profiler;
+
+void profileBegin(ProfilePhase phase) {
+    profiler.start[phase] = platformWallTimeUs();
+}
+
+// A phase can run several times a frame (one per simulation tick); the
+// frame's figure is the sum
+void profileEnd(ProfilePhase phase) {
+    profiler.current[phase] += (unsigned int)(platformWallTimeUs() - profiler.start[phase]);
+}
+
+static void refreshStats(void) {
+    unsigned int samples[PROFILE_HISTORY];
+    int n = profiler.count;
+    if(n == 0) return;
+
+    for(int phase = 0; phase < PHASE_COUNT; phase++) {
+        unsigned long long sum = 0;
+        for(int i = 0; i < n; i++) {
+            // Insertion sort; the ring is small and this runs a few times a second
+            unsigned int v = profiler.history[i][phase];
+            int j = i;
+            while(j > 0 && samples[j - 1] > v) { samples[j] = samples[j - 1]; j--; }
+            samples[j] = v;
+            sum += v;
+        }
+        profiler.stats[phase].min = samples[0];
+        profiler.stats[phase].avg = (unsigned int)(sum / n);
+        profiler.stats[phase].p99 = samples[(n * 99) / 100];
+    }
+}
+
+// Close the frame: push its phase times into the ring and start a new one
+void profileFrameEnd(void) {
+    memcpy(profiler.history[profiler.next], profiler.current, sizeof(profiler.current));
+    memset(profiler.current, 0, sizeof(profiler.current));
+    profiler.next = (profiler.next + 1) & (PROFILE_HISTORY - 1);
+    if(profiler.count < PROFILE_HISTORY) profiler.count++;
+
+    if(++profiler.sinceRefresh >= PROFILE_REFRESH) {
+        profiler.sinceRefresh = 0;
+        refreshStats();
+    }
+}
+
+const PhaseStats* profileStats(void) {
+    return profiler.stats;
+}
+
+const char* profilePhaseName(ProfilePhase phase) {
+    return phaseNames[phase];
+}
+
+// Write the ring as CSV, oldest frame first, followed by min/avg/p99 rows.
+// All times are microseconds
+int profileDump(const char* filename) {
+    FILE* f = fopen(filename, "w");
+    if(!f) return -1;
+
+    refreshStats();
+    fprintf(f, "frame");
+    for(int phase = 0; phase < PHASE_COUNT; phase++) fprintf(f, ",%s", phaseNames[phase]);
+    fprintf(f, "\n");
+
+    int first = (profiler.next - profiler.count) & (PROFILE_HISTORY - 1);
+    for(int i = 0; i < profiler.count; i++) {
+        const unsigned int* frame = profiler.history[(first + i) & (PROFILE_HISTORY - 1)];
+        fprintf(f, "%d", i);
+        for(int phase = 0; phase < PHASE_COUNT; phase++) fprintf(f, ",%u", frame[phase]);
+        fprintf(f, "\n");
+    }
+
+    static const char* rows[3] = {"min", "avg", "p99"};
+    for(int row = 0; row < 3; row++) {
+        fprintf(f, "%s", rows[row]);
+        for(int phase = 0; phase < PHASE_COUNT; phase++) {
+            const PhaseStats* s = &profiler.stats[phase];
+            fprintf(f, ",%u", row == 0 ? s->min : row == 1 ? s->avg : s->p99);
+        }
+        fprintf(f, "\n");
+    }
+
+    int failed = ferror(f);
+    if(fclose(f) != 0) failed = 1;
+    return failed ? -1 : 0;
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Frame profiler: wall-clock time per phase, summed over a frame and kept
+// for the last PROFILE_HISTORY frames. Timers are macros so a RELEASE build
+// compiles them, and everything else here, out entirely
+#ifndef PROFILER_H
+#define PROFILER_H
+
+typedef enum {
+    PHASE_INPUT,      // Pad read and applying it to the player
+    PHASE_SPAWN,
+    PHASE_MOVE,       // Bullets, enemy bullets and enemies
+    PHASE_COLLIDE,
+    PHASE_PARTICLES,
+    PHASE_BUILD,      // Display list build
+    PHASE_GPU,        // Waiting for the GE to finish the previous frame
+    PHASE_TEXT,       // HUD text layout and emission into the list
+    PHASE_VBLANK,     // Vblank wait and swap
+    PHASE_FRAME,      // Whole frame
+    PHASE_COUNT
+} ProfilePhase;
+
+#define PROFILE_HISTORY 256   // Frames kept, a power of two
+#define PROFILE_REFRESH 30    // Frames between stats refreshes
+#define PROFILE_FILE "profile.csv"  // TRIANGLE dumps here unless settings name a file
+
+// Microseconds over the frames in the ring
+typedef struct {
+    unsigned int min;
+    unsigned int avg;
+    unsigned int p99;
+} PhaseStats;
+
+#ifndef RELEASE
+
+#define PROFILE_BEGIN(phase) profileBegin(phase)
+#define PROFILE_END(phase) profileEnd(phase)
+#define PROFILE_FRAME_END() profileFrameEnd()
+
+void profileBegin(ProfilePhase phase);
+void profileEnd(ProfilePhase phase);
+void profileFrameEnd(void);
+const PhaseStats* profileStats(void);
+const char* profilePhaseName(ProfilePhase phase);
+int profileDump(const char* filename);
+
+#else
+
+#define PROFILE_BEGIN(phase) ((void)0)
+#define PROFILE_END(phase) ((void)0)
+#define PROFILE_FRAME_END() ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,717 @@
+#include <pspkernel.h>
+#include <pspdisplay.h>
+#include <pspgu.h>
+#include <pspgum.h>
+#include <math.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "game.h"
+#include "platform.h"
+#include "profiler.h"
+#include "font_psp.h"
+#include "audio.h"
+#include "mixer.h"
+#include "meshes.h"
+#include "assets.h"
+#include "cull.h"
+#include "terrain.h"
+
+#define BUF_WIDTH 512
+#define SCR_WIDTH 480
+#define SCR_HEIGHT 272
+
+// Frames are recorded as call lists and alternate between two buffers, so
+// the CPU builds frame N+1 while the GE is still drawing frame N. A tiny
+// direct list per buffer kicks each one off after the swap. The size can be
+// overridden at build time once the overlay's peak says how much is needed
+#ifndef LIST_BYTES
+#define LIST_BYTES (1024 * 1024)
+#endif
+#define LIST_RESERVE (8 * 1024)          // Kept back for the HUD and the end of the list
+#define CUBE_LIST_BYTES 256              // Upper bound on one drawCube's commands
+#define PARTICLE_LIST_BYTES 128          // Particle draw commands, besides the vertices
+static unsigned int __attribute__((aligned(16))) lists[2][LIST_BYTES / 4];
+static unsigned int __attribute__((aligned(16))) kickLists[2][64];
+static int currentList = 0;
+
+// Every 3D draw uses packed vertices: 5650 color and 16-bit positions, 8
+// bytes against 16 for float. The GE reads a 16-bit position as a fraction in
+// [-1, 1), so each draw scales its model matrix back up to the range packed
+#define PACKED_VERTEX_TYPE (GU_COLOR_5650|GU_VERTEX_16BIT)
+
+// Static meshes, set up once by initMeshes() and never written again
+typedef struct {
+    const struct PackedVertex* vertices;
+    int count;
+} Mesh;
+
+// Sparks are packed around the origin; the playfield is well inside +-64, and
+// a step of 1/512 is far below a spark's size
+#define PARTICLE_POSITION_SCALE 64.0f
+
+// Per-frame draw counters shown in the debug overlay
+typedef struct {
+    int drawCalls;
+    int vertices;
+    int particleDrawCalls;
+    int particleVertices;
+    int particles;
+    int terrainDrawCalls;
+    int terrainVertices;
+    CullStats culled;       // Entities outside the view and not drawn
+} RenderStats;
+
+// Display-list budget. Each part of the frame is charged with how far it
+// moved the list pointer
+typedef enum {
+    LIST_SETUP,       // Clear, matrices, debug triangle
+    LIST_TERRAIN,
+    LIST_ENTITIES,
+    LIST_PARTICLES,
+    LIST_HUD,
+    LIST_CATEGORY_COUNT
+} ListCategory;
+
+typedef struct {
+    int bytes[LIST_CATEGORY_COUNT];
+    int total;
+    int droppedEntities;    // Draws skipped because the list was nearly full
+    int droppedParticles;
+} ListUsage;
+
+// How the last GE frame overlapped the CPU, in microseconds
+typedef struct {
+    unsigned int gpu;       // Kick to GE finish
+    unsigned int overlap;   // Part of that the CPU spent simulating and building
+    unsigned int wait;      // CPU blocked in sceGuSync for it
+} GpuTiming;
+
+// Button edge to the vblank that first shows a frame reacting to it
+typedef struct {
+    unsigned int count;
+    unsigned int maxUs;
+    unsigned long long sumUs;
+} InputLatency;
+
+// Mesh registry: every shape lives in one aligned vertex array, so draw calls
+// just point the GE at it instead of rebuilding vertices each frame. The
+// local pool is only used when the asset archive has no baked meshes
+static struct PackedVertex __attribute__((aligned(16))) meshVertices[MESH_VERTEX_CAPACITY];
+static ScePspFVector3 meshScale = {MESH_POSITION_SCALE, MESH_POSITION_SCALE, MESH_POSITION_SCALE};
+static MeshRange meshRanges[MESH_COUNT];
+static Mesh meshes[MESH_COUNT];
+static RenderStats renderStats;
+static Frustum viewFrustum;          // This frame's camera, for culling
+static GpuTiming gpuTiming;
+static InputLatency inputLatency;
+static int listEdge[2];              // Whether each list's frame acts on an input edge...
+static uint64_t listEdgeUs[2];       // ...and when it was seen
+static ListUsage listUsage;          // Frame being built
+static ListUsage listLast;           // Last finished frame, for the overlay
+static ListUsage listPeak;           // High-water mark of each field
+static int listCutFrames = 0;        // Frames that had to drop draws
+static ListCategory listCategory;
+static int listSectionStart;
+static int gpuKicked = 0;
+static unsigned int kickUs;
+static volatile unsigned int gpuFinishUs;
+static TerrainVertex __attribute__((aligned(16))) terrainVertices[TERRAIN_VERTS];
+static unsigned short __attribute__((aligned(16))) terrainIndices[TERRAIN_INDICES];
+static TerrainLod terrainLods[TERRAIN_LODS];
+
+// Point every mesh at the vertices baked into the asset archive, where the
+// GE reads them in place. Without them, bake and pack the meshes into the
+// local pool
+static void initMeshes(void) {
+    const MeshRange* ranges = meshRanges;
+    const struct PackedVertex* vertices = meshVertices;
+    const PakEntry* entry = assetFind(ASSET_MESHES, PAK_MESHES);
+    const PakMeshTable* table = entry ? (const PakMeshTable*)assetData(entry) : NULL;
+
+    if(table && table->meshCount == MESH_COUNT && table->positionScale > 0) {
+        ranges = table->ranges;
+        vertices = (const struct PackedVertex*)((const char*)table + table->verticesOffset);
+        meshScale.x = meshScale.y = meshScale.z = table->positionScale;
+        // The archive was read through the dcache; the GE reads RAM
+        sceKernelDcacheWritebackRange(vertices, table->vertexCount * sizeof(struct PackedVertex));
+    } else {
+        static struct Vertex baked[MESH_VERTEX_CAPACITY];
+        int count = meshBake(baked, MESH_VERTEX_CAPACITY, meshRanges);
+        meshPack(baked, meshVertices, count, MESH_POSITION_SCALE);
+        sceKernelDcacheWritebackRange(meshVertices, sizeof(meshVertices));
+    }
+
+    for(int id = 0; id < MESH_COUNT; id++) {
+        meshes[id].vertices = vertices + ranges[id].first;
+        meshes[id].count = ranges[id].count;
+    }
+}
+
+// Bytes the frame can still use before it reaches the reserve
+static int listRoom(void) {
+    return LIST_BYTES - LIST_RESERVE - sceGuCheckList();
+}
+
+// Vertex memory from the list being built, or NULL when it would not fit
+static void* listAlloc(int bytes) {
+    if(listRoom() < bytes + 16) return NULL;  // sceGuGetMemory adds a jump and alignment
+    return sceGuGetMemory(bytes);
+}
+
+// Charge what was emitted since the last section to its category
+static void listSection(ListCategory category) {
+    int now = sceGuCheckList();
+    listUsage.bytes[listCategory] += now - listSectionStart;
+    listSectionStart = now;
+    listCategory = category;
+}
+
+static void listBeginFrame(void) {
+    memset(&listUsage, 0, sizeof(listUsage));
+    listCategory = LIST_SETUP;
+    listSectionStart = sceGuCheckList();
+}
+
+static void listEndFrame(void) {
+    listSection(LIST_SETUP);
+    listUsage.total = sceGuCheckList();
+
+    for(int c = 0; c < LIST_CATEGORY_COUNT; c++)
+        if(listUsage.bytes[c] > listPeak.bytes[c]) listPeak.bytes[c] = listUsage.bytes[c];
+    if(listUsage.total > listPeak.total) listPeak.total = listUsage.total;
+    if(listUsage.droppedEntities > listPeak.droppedEntities) listPeak.droppedEntities = listUsage.droppedEntities;
+    if(listUsage.droppedParticles > listPeak.droppedParticles) listPeak.droppedParticles = listUsage.droppedParticles;
+    if(listUsage.droppedEntities || listUsage.droppedParticles) listCutFrames++;
+    listLast = listUsage;
+}
+
+// True while another cube fits in the list; otherwise this draw counts as
+// dropped. Called only for entities in view, so culled ones are never counted
+static int cubeFits(void) {
+    if(listRoom() >= CUBE_LIST_BYTES) return 1;
+    listUsage.droppedEntities++;
+    return 0;
+}
+
+// All draws go through here so renderStats sees them
+static void submitDraw(int prim, int vtype, int count, const void* indices, const void* vertices) {
+    sceGumDrawArray(prim, vtype, count, indices, vertices);
+    renderStats.drawCalls++;
+    renderStats.vertices += count;
+}
+
+// Draw a mesh with the model matrix the caller set up
+static void drawMesh(MeshId id) {
+    sceGumScale(&meshScale);
+    submitDraw(GU_TRIANGLES, PACKED_VERTEX_TYPE|GU_TRANSFORM_3D,
+               meshes[id].count, 0, meshes[id].vertices);
+}
+
+static void drawCube(float x, float y, float z, float size, MeshId mesh) {
+    sceGumMatrixMode(GU_MODEL);
+    sceGumLoadIdentity();
+    ScePspFVector3 pos = {x, y, z};
+    sceGumTranslate(&pos);
+    ScePspFVector3 scale = {size, size, size};
+    sceGumScale(&scale);
+
+    drawMesh(mesh);
+}
+
+static float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+static const char* terrainDetailNames[TERRAIN_DETAIL_COUNT] = {"LOW", "MEDIUM", "HIGH"};
+
+// Build the LOD templates once; every row draws from them
+static void initTerrain(void) {
+    terrainBuild(terrainVertices, terrainIndices, terrainLods);
+
+    sceKernelDcacheWritebackRange(terrainVertices, sizeof(terrainVertices));
+    sceKernelDcacheWritebackRange(terrainIndices, sizeof(terrainIndices));
+}
+
+// Draw the rows on the ground this frame. A row keeps nothing between frames:
+// it is a translate, three morph weights and one draw of its level's
+// template. The per-row phase step is a fixed rotation, so the whole ground
+// costs two sinf/cosf per frame
+static void drawTerrain(float time, float eyeZ, int detail) {
+    TerrainRow rows[TERRAIN_ROWS];
+    terrainRows(time, eyeZ, detail, rows);
+    float stepCos = cosf(-0.3f * TERRAIN_CHUNK_DEPTH);
+    float stepSin = sinf(-0.3f * TERRAIN_CHUNK_DEPTH);
+    float phase = terrainPhase(time, rows[0].z);
+    float c = cosf(phase), s = sinf(phase);
+
+    sceGumMatrixMode(GU_MODEL);
+    ScePspFVector3 scale = {TERRAIN_SCALE_X, TERRAIN_SCALE_Y, TERRAIN_SCALE_Z};
+
+    for(int n = 0; n < TERRAIN_ROWS; n++) {
+        sceGumLoadIdentity();
+        ScePspFVector3 pos = {0, 0, rows[n].z};
+        sceGumTranslate(&pos);
+        sceGumScale(&scale);
+
+        // Weights must sum to 1 so x/z pass through unchanged; the flat frame
+        // absorbs the remainder (which can go negative)
+        sceGuMorphWeight(0, 1.0f - c - s);
+        sceGuMorphWeight(1, c);
+        sceGuMorphWeight(2, s);
+
+        const TerrainLod* lod = &terrainLods[rows[n].lod];
+        submitDraw(GU_TRIANGLES, GU_INDEX_16BIT|GU_VERTICES(TERRAIN_MORPH_FRAMES)|
+                   PACKED_VERTEX_TYPE|GU_TRANSFORM_3D,
+                   lod->indexCount, lod->indices, lod->vertices);
+        renderStats.terrainVertices += lod->indexCount;
+        renderStats.terrainDrawCalls++;
+
+        // Step the phase to the next row back
+        float nc = c * stepCos - s * stepSin;
+        s = s * stepCos + c * stepSin;
+        c = nc;
+    }
+}
+
+// Draw every live particle in view as a screen-aligned sprite in one draw
+// call. Each sprite is two opposite corners; the GE expands them after
+// projection. Room is taken for every live spark so each is lerped and tested
+// once; the slots of culled ones are left unused at the end of the block
+static void drawParticles(const Game* g, float alpha) {
+    const Particles* p = &g->particles;
+
+    // Sparks are drawn last, so they are what gets cut when the list runs short
+    int room = p->pool.count;
+    int fit = (listRoom() - PARTICLE_LIST_BYTES) / (2 * (int)sizeof(struct PackedVertex));
+    if(fit < room) room = fit > 0 ? fit : 0;
+    struct PackedVertex* v = room ? (struct PackedVertex*)listAlloc(room * 2 * sizeof(struct PackedVertex)) : NULL;
+    if(!v) room = 0;
+
+    const float s = 0.06f, k = PARTICLE_POSITION_SCALE;
+    int visible = 0, idx = 0;
+    for(int i = 0; i < p->pool.count; i++) {
+        float x = lerp(p->prevX[i], p->x[i], alpha);
+        float y = lerp(p->prevY[i], p->y[i], alpha);
+        float z = lerp(p->prevZ[i], p->z[i], alpha);
+        if(!frustumSphere(&viewFrustum, x, y, z, CULL_PARTICLE_RADIUS)) continue;
+        if(visible++ >= room) continue;
+        unsigned short color = meshColor5650(p->color[i]);
+        short qz = meshQuantize(z, k);
+        v[idx].color = color; v[idx].x = meshQuantize(x - s, k); v[idx].y = meshQuantize(y + s, k); v[idx++].z = qz;
+        v[idx].color = color; v[idx].x = meshQuantize(x + s, k); v[idx].y = meshQuantize(y - s, k); v[idx++].z = qz;
+    }
+
+    renderStats.particles = visible;
+    renderStats.culled.particles = p->pool.count - visible;
+    if(visible > room) listUsage.droppedParticles += visible - room;
+    if(idx == 0) return;
+
+    sceGumMatrixMode(GU_MODEL);
+    sceGumLoadIdentity();
+    ScePspFVector3 scale = {k, k, k};
+    sceGumScale(&scale);
+    submitDraw(GU_SPRITES, PACKED_VERTEX_TYPE|GU_TRANSFORM_3D, idx, 0, v);
+
+    renderStats.particleDrawCalls = 1;
+    renderStats.particleVertices = idx;
+}
+
+static void drawPlayer(ScePspFVector3 pos) {
+    // Body
+    drawCube(pos.x, pos.y, pos.z, 0.25f, MESH_CUBE_WHITE);
+
+    // Wings
+    sceGumMatrixMode(GU_MODEL);
+    sceGumLoadIdentity();
+    sceGumTranslate(&pos);
+
+    drawMesh(MESH_PLAYER_WINGS);
+}
+
+static void drawEnemy(const Enemies* e, int i, float alpha) {
+    sceGumMatrixMode(GU_MODEL);
+    sceGumLoadIdentity();
+    ScePspFVector3 pos = {lerp(e->prevX[i], e->x[i], alpha), lerp(e->prevY[i], e->y[i], alpha),
+                          lerp(e->prevZ[i], e->z[i], alpha)};
+    sceGumTranslate(&pos);
+    sceGumRotateY(lerp(e->prevAngle[i], e->angle[i], alpha));
+
+    drawMesh((MeshId)(MESH_ENEMY_BASIC + e->type[i]));
+}
+
+// Config menu overlay, over the HUD rows while the game is paused
+static void drawConfigMenu(const Game* g) {
+    char bar[11];
+    for(int i = 0; i < 10; i++) bar[i] = i < g->config.musicVolume ? '=' : '-';
+    bar[10] = '\0';
+
+    hudPrint(0, 0, 0xFF00FFFF, "=== CONFIG MENU ===");  // Cyan
+    hudPrint(1, 0, 0xFFFFFFFF, "Music Volume: [%s] %d/10", bar, g->config.musicVolume);
+    hudPrint(2, 0, 0xFFFFFFFF, "Terrain Detail: %s", terrainDetailNames[g->config.terrainDetail]);
+    hudPrint(3, 0, 0xFF00FF00, "LEFT/RIGHT=Volume UP/DOWN=Detail SELECT/X=Close");  // Green
+}
+
+// Runs in interrupt context when a kicked frame reaches its FINISH
+static void gpuFinished(int id) {
+    (void)id;
+    gpuFinishUs = sceKernelGetSystemTimeLow();
+}
+
+// Wait for the frame kicked last time round. Everything the CPU did since the
+// kick overlapped the GE up to the point the GE finished
+static void syncGpu(void) {
+    if(!gpuKicked) return;
+    unsigned int start = sceKernelGetSystemTimeLow();
+    sceGuSync(0, 0);
+    unsigned int end = sceKernelGetSystemTimeLow();
+    unsigned int cpu = start - kickUs;
+    gpuTiming.gpu = gpuFinishUs - kickUs;
+    gpuTiming.overlap = gpuTiming.gpu < cpu ? gpuTiming.gpu : cpu;
+    gpuTiming.wait = end - start;
+    gpuKicked = 0;
+}
+
+// Start the GE on a finished call list. The direct list also sets the draw
+// buffer, so this must come after the swap
+static void kickList(int index) {
+    sceGuStart(GU_DIRECT, kickLists[index]);
+    sceGuCallList(lists[index]);
+    sceGuFinish();
+    kickUs = sceKernelGetSystemTimeLow();
+    gpuKicked = 1;
+}
+
+void renderInit(void) {
+    sceGuInit();
+    sceGuStart(GU_DIRECT, kickLists[0]);
+    sceGuDrawBuffer(GU_PSM_8888, (void*)0, BUF_WIDTH);
+    sceGuDispBuffer(SCR_WIDTH, SCR_HEIGHT, (void*)0x88000, BUF_WIDTH);
+    sceGuDepthBuffer((void*)0x110000, BUF_WIDTH);
+    sceGuOffset(2048 - (SCR_WIDTH/2), 2048 - (SCR_HEIGHT/2));
+    sceGuViewport(2048, 2048, SCR_WIDTH, SCR_HEIGHT);
+    sceGuDepthRange(0, 65535);
+    sceGuScissor(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    sceGuEnable(GU_SCISSOR_TEST);
+    sceGuDepthFunc(GU_LEQUAL);
+    sceGuDisable(GU_DEPTH_TEST);  // TEMP: disable depth test for debugging
+    sceGuDisable(GU_CULL_FACE);
+    sceGuShadeModel(GU_SMOOTH);
+    sceGuFinish();
+    sceGuSync(0, 0);
+    sceDisplayWaitVblankStart();
+    sceGuDisplay(GU_TRUE);
+    sceGuSetCallback(GU_CALLBACK_FINISH, gpuFinished);
+
+    hudInit();
+    initTerrain();
+}
+
+// Loading screen: the stage being loaded over a progress bar. Built and kicked
+// like a game frame, so it alternates the same two lists
+void renderLoading(float progress, const char* stage) {
+    sceGuStart(GU_CALL, lists[currentList]);
+    sceGuClearColor(0xFF201008);
+    sceGuClear(GU_COLOR_BUFFER_BIT);
+
+    // Bar background, then the filled part
+    float fill = 90 + 300 * (progress < 0 ? 0 : progress > 1 ? 1 : progress);
+    // 2D positions are whole pixels, so they need no scaling
+    unsigned short back = meshColor5650(0xFF404040), front = meshColor5650(0xFF00C0FF);
+    struct PackedVertex* bar = (struct PackedVertex*)sceGuGetMemory(4 * sizeof(struct PackedVertex));
+    bar[0].color = back; bar[0].x = 90; bar[0].y = 150; bar[0].z = 0;
+    bar[1].color = back; bar[1].x = 390; bar[1].y = 158; bar[1].z = 0;
+    bar[2].color = front; bar[2].x = 90; bar[2].y = 150; bar[2].z = 0;
+    bar[3].color = front; bar[3].x = (short)fill; bar[3].y = 158; bar[3].z = 0;
+    sceGuDrawArray(GU_SPRITES, PACKED_VERTEX_TYPE|GU_TRANSFORM_2D, 4, 0, bar);
+
+    char text[HUD_COLUMNS + 1];
+    int length = snprintf(text, sizeof(text), "Loading %s...", stage);
+    if(length > HUD_COLUMNS) length = HUD_COLUMNS;
+    hudPrint(17, (HUD_COLUMNS - length) / 2, 0xFFFFFFFF, "%s", text);
+    hudDraw();
+    sceGuFinish();
+
+    syncGpu();
+    sceDisplayWaitVblankStart();
+    sceGuSwapBuffers();
+    kickList(currentList);
+    currentList ^= 1;
+}
+
+void renderAssetsReady(void) {
+    initMeshes();
+}
+
+#ifndef RELEASE
+// Phase table: min/avg/p99 in milliseconds, two phases per row
+static void drawProfileTable(int row) {
+    const PhaseStats* stats = profileStats();
+    hudPrint(row, 0, 0xFF00FFFF, "phase       min   avg   p99 | phase       min   avg   p99");
+    for(int phase = 0; phase < PHASE_FRAME; phase += 2) {
+        const PhaseStats* a = &stats[phase];
+        const PhaseStats* b = &stats[phase + 1];
+        hudPrint(row + 1 + phase / 2, 0, 0xFFFFFFFF, "%-9s %5.2f %5.2f %5.2f | %-9s %5.2f %5.2f %5.2f",
+                 profilePhaseName((ProfilePhase)phase), a->min / 1000.0f, a->avg / 1000.0f, a->p99 / 1000.0f,
+                 profilePhaseName((ProfilePhase)(phase + 1)), b->min / 1000.0f, b->avg / 1000.0f, b->p99 / 1000.0f);
+    }
+}
+#endif
+
+// Debug overlay: a status line on the bottom row, and above it the page of
+// figures R is on
+#define OVERLAY_ROW (HUD_ROWS - 1)
+static const char* overlayPageNames[OVERLAY_PAGES] = {"frame", "render", "audio", "off"};
+
+// Profiler table and GE timing
+static void drawFramePage(int row) {
+#ifndef RELEASE
+    drawProfileTable(row);
+#endif
+    hudPrint(row + 6, 0, 0xFF00FF00, "GE: %5.2fms busy %5.2fms overlapped %5.2fms waited",
+             gpuTiming.gpu / 1000.0f, gpuTiming.overlap / 1000.0f, gpuTiming.wait / 1000.0f);
+}
+
+// What reached the display list, and the pools behind it
+static void drawRenderPage(const Game* g, const FrameInfo* frame, int row) {
+    int enemyCount, bulletCount, eBulletCount, particleCount;
+    countEntities(g, &enemyCount, &bulletCount, &eBulletCount, &particleCount);
+    const HudStats* hud = hudStats();
+
+    // Live entities, and how many of them were outside the view and culled
+    const CullStats* culled = &renderStats.culled;
+    hudPrint(row, 0, 0xFF00FF00, "Live/culled: E%d/%d B%d/%d EB%d/%d P%d/%d",
+             enemyCount, culled->enemies, bulletCount, culled->bullets,
+             eBulletCount, culled->enemyBullets, particleCount, culled->particles);
+    // Particle cost next to what one cube draw per particle used to take
+    hudPrint(row + 1, 0, 0xFF00FF00, "Draws: %d Vtx: %d | Sparks: %d vtx %d dc (was %d/%d)",
+             renderStats.drawCalls, renderStats.vertices,
+             renderStats.particleVertices, renderStats.particleDrawCalls,
+             renderStats.particles * 36, renderStats.particles);
+    // Text rows re-laid out last frame out of those drawn
+    hudPrint(row + 2, 0, 0xFF00FF00, "Terrain: %d vtx %d dc | Detail: %s | Text: %d/%d",
+             renderStats.terrainVertices, renderStats.terrainDrawCalls,
+             terrainDetailNames[g->config.terrainDetail], hud->rebuilt, hud->rows);
+    // Display-list use of the last frame in KB; red while draws are being cut
+    unsigned int listColor = (listLast.droppedEntities || listLast.droppedParticles) ? 0xFF0000FF : 0xFF00FF00;
+    hudPrint(row + 3, 0, listColor, "List: %dKB of %dKB, peak %dKB | cut E%d P%d in %d frames",
+             listLast.total / 1024, LIST_BYTES / 1024, listPeak.total / 1024,
+             listLast.droppedEntities, listLast.droppedParticles, listCutFrames);
+    hudPrint(row + 4, 0, listColor, "KB now/peak: S%d/%d T%d/%d E%d/%d P%d/%d H%d/%d",
+             listLast.bytes[LIST_SETUP] / 1024, listPeak.bytes[LIST_SETUP] / 1024,
+             listLast.bytes[LIST_TERRAIN] / 1024, listPeak.bytes[LIST_TERRAIN] / 1024,
+             listLast.bytes[LIST_ENTITIES] / 1024, listPeak.bytes[LIST_ENTITIES] / 1024,
+             listLast.bytes[LIST_PARTICLES] / 1024, listPeak.bytes[LIST_PARTICLES] / 1024,
+             listLast.bytes[LIST_HUD] / 1024, listPeak.bytes[LIST_HUD] / 1024);
+    // Allocations refused by each pool since the game started
+    hudPrint(row + 5, 0, 0xFF00FF00, "Pool dry: B%d E%d EB%d P%d | Arena: %dKB",
+             g->bullets.pool.failures, g->enemies.pool.failures,
+             g->enemyBullets.pool.failures, g->particles.pool.failures,
+             (int)(frame->arenaSize / 1024));
+}
+
+// Sound, music streaming, input and startup latencies
+static void drawAudioPage(const FrameInfo* frame, int row) {
+    // Button press to the frame that answers it being shown
+    hudPrint(row, 0, 0xFF00FF00, "Input: %dms avg %dms max over %u edges | late latch %s",
+             inputLatency.count ? (int)(inputLatency.sumUs / inputLatency.count / 1000) : 0,
+             inputLatency.maxUs / 1000, inputLatency.count, frame->lateLatch ? "on" : "off");
+    // Startup: loading screen up, then the game taking input
+    hudPrint(row + 1, 0, 0xFF00FF00, "Startup: first frame %dms, interactive %dms",
+             frame->firstFrameUs / 1000, frame->interactiveUs / 1000);
+    // Effect trigger-to-output latency and the audio thread's share of the CPU
+    AudioStats audio;
+    audioStats(&audio);
+    hudPrint(row + 2, 0, 0xFF00FF00, "SFX latency %dms avg %dms max | %d-sample blocks, audio CPU %d.%02d%%",
+             audio.latencyAvgUs / 1000, audio.latencyMaxUs / 1000, audio.blockSamples,
+             audio.busyBasisPoints / 100, audio.busyBasisPoints % 100);
+    // Mixer voices and how far ahead the music decoder is; red once it has starved
+    MixerStats mixer;
+    MusicStats music;
+    mixerStats(&mixer);
+    musicStats(&music);
+    hudPrint(row + 3, 0, music.underruns ? 0xFF0000FF : 0xFF00FF00,
+             "Voices %d/%d peak %d | Music min %dms ahead, %u underruns",
+             mixer.active, MIXER_VOICES, mixer.peak,
+             (int)(music.minBufferedFrames * 1000ull / AUDIO_SAMPLE_RATE), music.underruns);
+    // Music file reads per decoder request, seeks served from the buffers,
+    // and how often and long the decoder waited on the file
+    hudPrint(row + 4, 0, 0xFF00FF00, "Music I/O: %u/%u reads | seeks %u/%u buf | %u stalls %ums",
+             music.io.fileReads, music.io.requests, music.io.seeksBuffered, music.io.seeks,
+             music.io.stalls, music.io.stallUs / 1000);
+}
+
+static void drawOverlay(const Game* g, const FrameInfo* frame) {
+    const char* stateStr = (g->state == STATE_PLAYING) ? "PLAY" :
+                           (g->state == STATE_CONFIG_MENU) ? "CONFIG" : "GAMEOVER";
+    int page = frame->overlayPage;
+#ifndef RELEASE
+    const PhaseStats* frameStats = &profileStats()[PHASE_FRAME];
+    hudPrint(OVERLAY_ROW, 0, 0xFF00FF00, "Frame %5.2f/%5.2fms avg/p99 | FPS %.1f %s | T%d D%d R:%s",
+             frameStats->avg / 1000.0f, frameStats->p99 / 1000.0f, frame->fps, stateStr,
+             frame->ticks, frame->droppedTicks, overlayPageNames[page]);
+#else
+    hudPrint(OVERLAY_ROW, 0, 0xFF00FF00, "FPS: %.1f | State: %s | Ticks: %d Dropped: %d R:%s",
+             frame->fps, stateStr, frame->ticks, frame->droppedTicks, overlayPageNames[page]);
+#endif
+
+    // Pages sit right above the status line; the tallest is seven rows
+    int top = OVERLAY_ROW - 7;
+    if(page == OVERLAY_FRAME) drawFramePage(top);
+    else if(page == OVERLAY_RENDER) drawRenderPage(g, frame, top + 1);
+    else if(page == OVERLAY_AUDIO) drawAudioPage(frame, top + 2);
+}
+
+void renderFrame(const Game* g, float alpha, const FrameInfo* frame) {
+    PROFILE_BEGIN(PHASE_BUILD);
+    memset(&renderStats, 0, sizeof(renderStats));
+    // The other buffer's frame may still be drawing; this one was synced
+    // before the last kick
+    sceGuStart(GU_CALL, lists[currentList]);
+    listBeginFrame();
+    sceGuClearColor(0xFFFFE0C0);
+    sceGuClearDepth(65535);
+    sceGuClear(GU_COLOR_BUFFER_BIT|GU_DEPTH_BUFFER_BIT);
+
+    // DEBUG: Draw a simple 2D red triangle to test if GU works at all
+    {
+        sceGumMatrixMode(GU_PROJECTION);
+        sceGumLoadIdentity();
+        sceGumOrtho(0, 480, 272, 0, -1, 1);
+        sceGumMatrixMode(GU_VIEW);
+        sceGumLoadIdentity();
+        sceGumMatrixMode(GU_MODEL);
+        sceGumLoadIdentity();
+        ScePspFVector3 scale = {512, 512, 1};
+        sceGumScale(&scale);
+
+        unsigned short red = meshColor5650(0xFF0000FF);
+        struct PackedVertex* v = (struct PackedVertex*)sceGuGetMemory(3 * sizeof(struct PackedVertex));
+        v[0].color = red; v[0].x = meshQuantize(240, 512); v[0].y = meshQuantize(50, 512);  v[0].z = 0;
+        v[1].color = red; v[1].x = meshQuantize(340, 512); v[1].y = meshQuantize(150, 512); v[1].z = 0;
+        v[2].color = red; v[2].x = meshQuantize(140, 512); v[2].y = meshQuantize(150, 512); v[2].z = 0;
+        submitDraw(GU_TRIANGLES, PACKED_VERTEX_TYPE|GU_TRANSFORM_3D, 3, 0, v);
+    }
+
+    // Setup 3D
+    sceGumMatrixMode(GU_PROJECTION);
+    sceGumLoadIdentity();
+    sceGumPerspective(CAMERA_FOV, CAMERA_ASPECT, CAMERA_NEAR, CAMERA_FAR);
+
+    sceGumMatrixMode(GU_VIEW);
+    sceGumLoadIdentity();
+    // The player and camera sit between the last two ticks, or where the
+    // main loop's late latch put them
+    const Player* pl = &g->player;
+    ScePspFVector3 player = {lerp(pl->prevX, pl->x, alpha), lerp(pl->prevY, pl->y, alpha),
+                             lerp(pl->prevZ, pl->z, alpha)};
+    if(frame->latched) {
+        player.x = frame->latchedX;
+        player.y = frame->latchedY;
+    }
+    listEdge[currentList] = frame->inputEdge;
+    listEdgeUs[currentList] = frame->inputEdgeUs;
+    float view[2][3];
+    cameraView(player.x, player.y, player.z, view[0], view[1]);
+    ScePspFVector3 eye = {view[0][0], view[0][1], view[0][2]};
+    ScePspFVector3 center = {view[1][0], view[1][1], view[1][2]};
+    ScePspFVector3 up = {0, 1, 0};
+    sceGumLookAt(&eye, &center, &up);
+    cameraFrustum(&viewFrustum, player.x, player.y, player.z);
+
+    // Draw scene
+    listSection(LIST_TERRAIN);
+    drawTerrain(g->time - (1.0f - alpha) * SIM_DT, eye.z, g->config.terrainDetail);
+    listSection(LIST_ENTITIES);
+    drawPlayer(player);
+
+    const Bullets* b = &g->bullets;
+    // Entities outside the view are skipped before they reach the list
+    for(int i = 0; i < b->pool.count; i++) {
+        float x = lerp(b->prevX[i], b->x[i], alpha), y = lerp(b->prevY[i], b->y[i], alpha);
+        float z = lerp(b->prevZ[i], b->z[i], alpha);
+        if(!frustumSphere(&viewFrustum, x, y, z, CULL_BULLET_RADIUS)) {
+            renderStats.culled.bullets++;
+            continue;
+        }
+        if(!cubeFits()) continue;
+        drawCube(x, y, z, 0.08f, MESH_CUBE_YELLOW);
+    }
+
+    const Enemies* e = &g->enemies;
+    float enemyRadius = cullEnemyRadius();
+    for(int i = 0; i < e->pool.count; i++) {
+        if(!frustumSphere(&viewFrustum, lerp(e->prevX[i], e->x[i], alpha), lerp(e->prevY[i], e->y[i], alpha),
+                          lerp(e->prevZ[i], e->z[i], alpha), enemyRadius)) {
+            renderStats.culled.enemies++;
+            continue;
+        }
+        if(!cubeFits()) continue;
+        drawEnemy(e, i, alpha);
+    }
+
+    // Draw enemy bullets
+    const EnemyBullets* eb = &g->enemyBullets;
+    for(int i = 0; i < eb->pool.count; i++) {
+        float x = lerp(eb->prevX[i], eb->x[i], alpha), y = lerp(eb->prevY[i], eb->y[i], alpha);
+        float z = lerp(eb->prevZ[i], eb->z[i], alpha);
+        if(!frustumSphere(&viewFrustum, x, y, z, CULL_BULLET_RADIUS)) {
+            renderStats.culled.enemyBullets++;
+            continue;
+        }
+        if(!cubeFits()) continue;
+        drawCube(x, y, z, 0.08f, MESH_CUBE_BLUE);
+    }
+
+    listSection(LIST_PARTICLES);
+    drawParticles(g, alpha);
+    PROFILE_END(PHASE_BUILD);
+
+    // UI: text goes into the same list as the scene, on top of it
+    PROFILE_BEGIN(PHASE_TEXT);
+    if(g->state == STATE_GAME_OVER) {
+        hudPrint(0, 0, 0xFFFFFFFF, "GAME OVER!");
+        hudPrint(1, 0, 0xFFFFFFFF, "Final Score: %d", g->score);
+        hudPrint(2, 0, 0xFFFFFFFF, "Press X to Restart | START=Exit");
+    } else if (g->state == STATE_CONFIG_MENU) {
+        drawConfigMenu(g);
+    } else {
+        hudPrint(0, 0, 0xFFFFFFFF, "Score: %d | Health: %d | Vol: %d/10", g->score, g->player.health, g->config.musicVolume);
+        hudPrint(1, 0, 0xFFFFFFFF, "D-Pad=Move X=Shoot SELECT=Config START=Exit");
+    }
+
+    drawOverlay(g, frame);
+    listSection(LIST_HUD);
+    hudDraw();
+    listEndFrame();
+    PROFILE_END(PHASE_TEXT);
+    sceGuFinish();
+
+    // The previous frame has to be on screen before this one can be kicked
+    PROFILE_BEGIN(PHASE_GPU);
+    syncGpu();
+    PROFILE_END(PHASE_GPU);
+
+    PROFILE_BEGIN(PHASE_VBLANK);
+    sceDisplayWaitVblankStart();
+    sceGuSwapBuffers();
+    PROFILE_END(PHASE_VBLANK);
+
+    // The frame going up now is the one built last time round
+    if(listEdge[currentList ^ 1]) {
+        unsigned int us = (unsigned int)(platformWallTimeUs() - listEdgeUs[currentList ^ 1]);
+        inputLatency.count++;
+        inputLatency.sumUs += us;
+        if(us > inputLatency.maxUs) inputLatency.maxUs = us;
+        listEdge[currentList ^ 1] = 0;
+    }
+
+    // The GE draws this frame while the CPU runs the next one
+    kickList(currentList);
+    currentList ^= 1;
+}
+
+void renderShutdown(void) {
+    syncGpu();
+    sceGuTerm();
+}
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay.h"
+
+// File layout, all fields 32-bit little-endian:
+//   "RPLY" version seed bullets enemies enemyBullets particles flags
+//   tickCount runCount, runCount x (count input), tickCount x hash if flagged
+#define REPLAY_MAGIC "RPLY"
+#define REPLAY_VERSION 1
+#define REPLAY_FLAG_HASHES 1
+#define REPLAY_HEADER_BYTES 40
+
+void replayInit(Replay* r, unsigned int seed, const Capacities* caps, int withHashes) {
+    memset(r, 0, sizeof(*r));
+    r->seed = seed;
+    r->capacities = *caps;
+    r->hashing = withHashes;
+}
+
+void replayFree(Replay* r) {
+    free(r->runs);
+    free(r->hashes);
+    r->runs = NULL;
+    r->hashes = NULL;
+}
+
+// Append one tick. Consecutive equal inputs share a run, so a held direction
+// or an idle stretch costs 8 bytes however long it lasts
+int replayRecordTick(Replay* r, unsigned int input, unsigned int hash) {
+    if(r->runCount > 0 && r->runs[r->runCount - 1].input == input) {
+        r->runs[r->runCount - 1].count++;
+    } else {
+        if(r->runCount == r->runCapacity) {
+            int capacity = r->runCapacity ? r->runCapacity * 2 : 256;
+            ReplayRun* runs = (ReplayRun*)realloc(r->runs, capacity * sizeof(ReplayRun));
+            if(!runs) return -1;
+            r->runs = runs;
+            r->runCapacity = capacity;
+        }
+        r->runs[r->runCount].count = 1;
+        r->runs[r->runCount].input = input;
+        r->runCount++;
+    }
+
+    if(r->hashing) {
+        if(r->tickCount == r->hashCapacity) {
+            int capacity = r->hashCapacity ? r->hashCapacity * 2 : 4096;
+            unsigned int* hashes = (unsigned int*)realloc(r->hashes, capacity * sizeof(unsigned int));
+            if(!hashes) return -1;
+            r->hashes = hashes;
+            r->hashCapacity = capacity;
+        }
+        r->hashes[r->tickCount] = hash;
+    }
+    r->tickCount++;
+    return 0;
+}
+
+static void putU32(FILE* f, unsigned int v) {
+    unsigned char b[4] = {v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, v >> 24};
+    fwrite(b, 1, 4, f);
+}
+
+static int getU32(FILE* f, unsigned int* v) {
+    unsigned char b[4];
+    if(fread(b, 1, 4, f) != 4) return -1;
+    *v = b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int)b[3] << 24);
+    return 0;
+}
+
+int replaySave(const Replay* r, const char* filename) {
+    FILE* f = fopen(filename, "wb");
+    if(!f) return -1;
+
+    fwrite(REPLAY_MAGIC, 1, 4, f);
+    putU32(f, REPLAY_VERSION);
+    putU32(f, r->seed);
+    putU32(f, r->capacities.bullets);
+    putU32(f, r->capacities.enemies);
+    putU32(f, r->capacities.enemyBullets);
+    putU32(f, r->capacities.particles);
+    putU32(f, r->hashing ? REPLAY_FLAG_HASHES : 0);
+    putU32(f, r->tickCount);
+    putU32(f, r->runCount);
+    for(int i = 0; i < r->runCount; i++) {
+        putU32(f, r->runs[i].count);
+        putU32(f, r->runs[i].input);
+    }
+    if(r->hashing) {
+        for(int i = 0; i < r->tickCount; i++) putU32(f, r->hashes[i]);
+    }
+
+    int failed = ferror(f);
+    if(fclose(f) != 0) failed = 1;
+    return failed ? -1 : 0;
+}
+
+int replayLoad(Replay* r, const char* filename) {
+    memset(r, 0, sizeof(*r));
+    FILE* f = fopen(filename, "rb");
+    if(!f) return -1;
+
+    char magic[4];
+    unsigned int version, caps[4], flags, ticks, runs;
+    if(fread(magic, 1, 4, f) != 4 || memcmp(magic, REPLAY_MAGIC, 4) != 0 ||
+       getU32(f, &version) || version != REPLAY_VERSION || getU32(f, &r->seed) ||
+       getU32(f, &caps[0]) || getU32(f, &caps[1]) || getU32(f, &caps[2]) || getU32(f, &caps[3]) ||
+       getU32(f, &flags) || getU32(f, &ticks) || getU32(f, &runs)) {
+        fclose(f);
+        return -1;
+    }
+    // The counts must describe exactly the bytes that follow, so nothing is
+    // allocated for a file that cannot hold it, and sizes cannot wrap
+    long size = -1;
+    if(fseek(f, 0, SEEK_END) == 0) size = ftell(f);
+    unsigned long long expected = REPLAY_HEADER_BYTES + 8ull * runs +
+                                  ((flags & REPLAY_FLAG_HASHES) ? 4ull * ticks : 0);
+    if(size < 0 || expected != (unsigned long long)size || ticks > 0x7FFFFFFFu ||
+       fseek(f, REPLAY_HEADER_BYTES, SEEK_SET) != 0) {
+        fclose(f);
+        return -1;
+    }
+
+    r->capacities.bullets = caps[0];
+    r->capacities.enemies = caps[1];
+    r->capacities.enemyBullets = caps[2];
+    r->capacities.particles = caps[3];
+    r->tickCount = ticks;
+
+    r->runs = (ReplayRun*)malloc((runs ? runs : 1) * sizeof(ReplayRun));
+    r->runCount = r->runCapacity = runs;
+    int ok = r->runs != NULL;
+    unsigned long long runTicks = 0;
+    for(unsigned int i = 0; ok && i < runs; i++) {
+        ok = !getU32(f, &r->runs[i].count) && !getU32(f, &r->runs[i].input);
+        if(ok) runTicks += r->runs[i].count;
+    }
+    // Playback indexes the hashes by tick, so the runs must add up
+    if(runTicks != ticks) ok = 0;
+    r->hashing = (flags & REPLAY_FLAG_HASHES) != 0;
+    if(ok && r->hashing) {
+        r->hashes = (unsigned int*)malloc((ticks ? ticks : 1) * sizeof(unsigned int));
+        r->hashCapacity = ticks;
+        ok = r->hashes != NULL;
+        for(unsigned int i = 0; ok && i < ticks; i++) ok = !getU32(f, &r->hashes[i]);
+    }
+    fclose(f);
+
+    if(!ok) {
+        replayFree(r);
+        return -1;
+    }
+    return 0;
+}
+
+// Playback: the next tick's input word, or 0 once the recording is exhausted
+int replayNextInput(Replay* r, unsigned int* input) {
+    while(r->cursorRun < r->runCount && r->cursorOffset >= r->runs[r->cursorRun].count) {
+        r->cursorRun++;
+        r->cursorOffset = 0;
+    }
+    if(r->cursorRun >= r->runCount) return 0;
+
+    *input = r->runs[r->cursorRun].input;
+    r->cursorOffset++;
+    return 1;
+}
@@ -0,0 +1,45 @@
+// Replays: the seed, the entity capacities and one input word per simulation
+// tick, run-length encoded. Feeding the same words to tickGame from the same
+// seed reproduces the session exactly; an optional per-tick state hash
+// pinpoints the first tick where a playback drifts from the recording
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "game.h"
+
+// Tick input word: held buttons in the low 16 bits, buttons pressed since
+// the previous tick in bits 16-30, and REPLAY_RESTART when the game was
+// restarted (initGame) just before this tick
+#define REPLAY_RESTART 0x80000000u
+
+#define REPLAY_INPUT(buttons, pressed) (((buttons) & 0xFFFFu) | (((pressed) & 0x7FFFu) << 16))
+#define REPLAY_BUTTONS(input) ((input) & 0xFFFFu)
+#define REPLAY_PRESSED(input) (((input) >> 16) & 0x7FFFu)
+
+typedef struct {
+    unsigned int count;
+    unsigned int input;
+} ReplayRun;
+
+typedef struct {
+    unsigned int seed;
+    Capacities capacities;
+    ReplayRun* runs;
+    int runCount, runCapacity;
+    int hashing;                // Whether hashes holds one state hash per tick
+    unsigned int* hashes;
+    int tickCount, hashCapacity;
+
+    // Playback cursor
+    int cursorRun;
+    unsigned int cursorOffset;
+} Replay;
+
+void replayInit(Replay* r, unsigned int seed, const Capacities* caps, int withHashes);
+void replayFree(Replay* r);
+int replayRecordTick(Replay* r, unsigned int input, unsigned int hash);
+int replaySave(const Replay* r, const char* filename);
+int replayLoad(Replay* r, const char* filename);
+int replayNextInput(Replay* r, unsigned int* input);
+
+#endif
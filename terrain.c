@@ -0,0 +1,106 @@
+#include <math.h>
+
+#include "terrain.h"
+#include "game.h"
+
+// Distance along z from the camera to the nearest part of a chunk below which
+// each LOD is used; chunks further out than the last entry get the coarsest
+// level. Low detail never uses LOD 0
+static const float terrainLodDistance[TERRAIN_DETAIL_COUNT][TERRAIN_LODS - 1] = {
+    { 0.0f, 16.0f, 40.0f},   // Low
+    { 8.0f, 24.0f, 56.0f},   // Medium
+    {16.0f, 40.0f, 72.0f}    // High
+};
+
+// Build one LOD template: a grid from z = 0 back to -TERRAIN_CHUNK_DEPTH with a
+// skirt hanging off its near and far edges. A finer neighbour's edge has
+// vertices between this one's, so the two edges only meet at shared columns;
+// the skirts fill the gaps whichever side the finer chunk is on. Each vertex
+// carries three morph targets (flat, +sin and +cos of its local phase) so the
+// renderer animates the waves with morph weights alone:
+// sin(a + t) = sin(a)cos(t) + cos(a)sin(t)
+static int buildLod(TerrainLod* lod, TerrainVertex* verts, unsigned short* indices, int level) {
+    float cell = TERRAIN_CELL_SIZE * (1 << level);
+    int rows = (int)(TERRAIN_CHUNK_DEPTH / cell);
+    int columns = (int)(TERRAIN_CHUNK_WIDTH / cell);
+    int stride = columns + 1;
+    int nearSkirt = (rows + 1) * stride, farSkirt = nearSkirt + stride;
+    int idx = 0;
+
+    // Grid lines 0..rows, then the skirt lines below row 0 and row rows
+    for(int j = 0; j <= rows + 2; j++) {
+        for(int i = 0; i <= columns; i++) {
+            TerrainVertex* tv = &verts[j * stride + i];
+            float x = (i - columns / 2) * cell;
+            float z = (j <= rows) ? -j * cell : (j == rows + 1) ? 0 : -rows * cell;
+            float drop = (j <= rows) ? 0 : TERRAIN_SKIRT_DEPTH;
+            float a = x * 0.3f + z * 0.3f;
+            float h[TERRAIN_MORPH_FRAMES] = {0, sinf(a) * 0.3f, cosf(a) * 0.3f};
+
+            for(int f = 0; f < TERRAIN_MORPH_FRAMES; f++) {
+                tv->frame[f].color = meshColor5650(0xFF00CC00);
+                tv->frame[f].x = meshQuantize(x, TERRAIN_SCALE_X);
+                tv->frame[f].y = meshQuantize(-2.0f + h[f] - drop, TERRAIN_SCALE_Y);
+                tv->frame[f].z = meshQuantize(z, TERRAIN_SCALE_Z);
+            }
+        }
+    }
+
+    for(int j = 0; j < rows; j++) {
+        for(int i = 0; i < columns; i++) {
+            unsigned short v00 = j * stride + i;
+            unsigned short v10 = v00 + 1;
+            unsigned short v01 = v00 + stride;
+            unsigned short v11 = v01 + 1;
+            indices[idx++] = v01; indices[idx++] = v11; indices[idx++] = v00;
+            indices[idx++] = v11; indices[idx++] = v10; indices[idx++] = v00;
+        }
+    }
+    for(int i = 0; i < columns; i++) {
+        unsigned short top = i, bottom = nearSkirt + i;
+        indices[idx++] = top; indices[idx++] = top + 1; indices[idx++] = bottom;
+        indices[idx++] = top + 1; indices[idx++] = bottom + 1; indices[idx++] = bottom;
+        top = rows * stride + i; bottom = farSkirt + i;
+        indices[idx++] = top; indices[idx++] = top + 1; indices[idx++] = bottom;
+        indices[idx++] = top + 1; indices[idx++] = bottom + 1; indices[idx++] = bottom;
+    }
+
+    lod->vertices = verts;
+    lod->indices = indices;
+    lod->indexCount = idx;
+    lod->columns = columns;
+    lod->rows = rows;
+    return (rows + 3) * stride;
+}
+
+void terrainBuild(TerrainVertex* vertices, unsigned short* indices, TerrainLod lods[TERRAIN_LODS]) {
+    int vertexOffset = 0, indexOffset = 0;
+    for(int l = 0; l < TERRAIN_LODS; l++) {
+        vertexOffset += buildLod(&lods[l], &vertices[vertexOffset], &indices[indexOffset], l);
+        indexOffset += lods[l].indexCount;
+    }
+}
+
+void terrainRows(float time, float eyeZ, int detail, TerrainRow rows[TERRAIN_ROWS]) {
+    float scroll = time * 2;
+    int firstRow = (int)floorf((scroll - TERRAIN_VIEW_BEHIND) / TERRAIN_CHUNK_DEPTH);
+
+    for(int n = 0; n < TERRAIN_ROWS; n++) {
+        TerrainRow* r = &rows[n];
+        r->row = firstRow + n;
+        r->z = scroll - r->row * TERRAIN_CHUNK_DEPTH;
+
+        // Zero for the row under the camera; rows wholly behind it are
+        // measured to their far edge
+        float dist = eyeZ - r->z;
+        if(dist < 0) dist = fmaxf(0, r->z - TERRAIN_CHUNK_DEPTH - eyeZ);
+        r->lod = TERRAIN_LODS - 1;
+        for(int l = 0; l < TERRAIN_LODS - 1; l++) {
+            if(dist < terrainLodDistance[detail][l]) { r->lod = l; break; }
+        }
+    }
+}
+
+float terrainPhase(float time, float z) {
+    return time + z * 0.3f;
+}
@@ -0,0 +1,62 @@
+// Terrain: rows of heightfield chunks scrolling toward the camera. Every chunk
+// is drawn from one of TERRAIN_LODS shared template meshes; each coarser level
+// doubles the cell size over the same footprint, so it has half the columns
+// and rows and neighbouring chunks line up whatever their levels. The
+// templates and which level each row gets live here, away from the GU, so the
+// headless build can count and check them
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include "meshes.h"
+
+#define TERRAIN_LODS 4
+#define TERRAIN_CHUNK_WIDTH 64.0f
+#define TERRAIN_CHUNK_DEPTH 16.0f
+#define TERRAIN_CELL_SIZE 2.0f                // Cell size at LOD 0
+#define TERRAIN_ROWS 9                        // Chunk rows on the ground each frame
+#define TERRAIN_VIEW_BEHIND 8.0f              // How far behind the camera the first row starts
+#define TERRAIN_SKIRT_DEPTH 1.0f              // Hides cracks where LODs meet
+#define TERRAIN_MORPH_FRAMES 3
+// (columns + 1) * (rows + 1 grid lines and 2 skirt lines) per LOD, with
+// columns = 32, 16, 8, 4 and rows = 8, 4, 2, 1
+#define TERRAIN_VERTS (33 * 11 + 17 * 7 + 9 * 5 + 5 * 4)
+#define TERRAIN_INDICES (6 * (32 * 10 + 16 * 6 + 8 * 4 + 4 * 3))
+
+// Packed terrain range per axis: x out to +-32, heights around -2, and chunks
+// TERRAIN_CHUNK_DEPTH deep. x and z sit on the 2-unit grid and pack exactly;
+// heights are within 1/16384 of a unit
+#define TERRAIN_SCALE_X 64.0f
+#define TERRAIN_SCALE_Y 4.0f
+#define TERRAIN_SCALE_Z TERRAIN_CHUNK_DEPTH
+
+// A terrain vertex is all of its morph targets back to back, as the GE expects
+typedef struct {
+    struct PackedVertex frame[TERRAIN_MORPH_FRAMES];
+} TerrainVertex;
+
+// Template mesh for one level of detail
+typedef struct {
+    const TerrainVertex* vertices;
+    const unsigned short* indices;
+    int indexCount;
+    int columns;
+    int rows;
+} TerrainLod;
+
+// One row of chunks in a given frame
+typedef struct {
+    int row;        // Row number; row k's near edge sits at scroll - k * depth
+    float z;        // World z of its near edge
+    int lod;
+} TerrainRow;
+
+// Build every LOD template into vertices and indices, sized TERRAIN_VERTS and
+// TERRAIN_INDICES
+void terrainBuild(TerrainVertex* vertices, unsigned short* indices, TerrainLod lods[TERRAIN_LODS]);
+// The TERRAIN_ROWS rows on the ground at this time, nearest first, and
+// the level each gets for a camera at eyeZ
+void terrainRows(float time, float eyeZ, int detail, TerrainRow rows[TERRAIN_ROWS]);
+// Wave phase of a row's near edge: time plus 0.3 * its world z
+float terrainPhase(float time, float z);
+
+#endif
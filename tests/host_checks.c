@@ -0,0 +1,715 @@
+// Host-only checks and benchmarks, run by the headless Linux build's --bench-*
+// and --check-* flags. Each runs once, prints a report and returns the exit
+// status: non-zero when what it checks does not hold.
+//
+//   --bench-mixer         sound mixer cost per block at 1, 8 and 32 voices
+//   --bench-collision     collision grid against brute force
+//   --bench-movement      entity movement in the old record layout against the packed arrays
+//   --stress-audio-queue  audio command queue across two threads
+//   --check-culling       view frustum against projected spheres and shapes
+//   --check-meshes        mesh registry against the shapes the renderer used to build every frame
+//   --check-terrain       terrain vertices per frame at each detail setting, and LOD seams
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "host_checks.h"
+#include "../platform.h"
+#include "../mixer.h"
+#include "../audio_queue.h"
+#include "../audio.h"
+#include "../cull.h"
+#include "../meshes.h"
+#include "../terrain.h"
+
+static float randomFloat(unsigned int* state, float lo, float hi) {
+    *state = *state * 1664525u + 1013904223u;
+    return lo + (hi - lo) * (*state >> 8) / 16777216.0f;
+}
+
+// Mixing cost of one output block at a few voice counts. Every voice plays a
+// long full-scale sample so none of them ends during a run
+static int benchmarkMixer(void) {
+    enum { SOURCE_BLOCKS = 64, RUNS = 40 };
+    static short source[AUDIO_MAX_BLOCK_SAMPLES * SOURCE_BLOCKS * 2];
+    static short music[AUDIO_MAX_BLOCK_SAMPLES * 2];
+    static short out[AUDIO_MAX_BLOCK_SAMPLES * 2];
+    static const int voiceCounts[] = {1, 8, 32};
+
+    for(int i = 0; i < AUDIO_MAX_BLOCK_SAMPLES * SOURCE_BLOCKS * 2; i++) source[i] = (short)(i * 97);
+    for(int i = 0; i < AUDIO_MAX_BLOCK_SAMPLES * 2; i++) music[i] = (short)(i * 31);
+    Sample sample = {source, AUDIO_MAX_BLOCK_SAMPLES * SOURCE_BLOCKS};
+
+#if defined(__SSE2__)
+    const char* path = "SSE2";
+#elif defined(__ARM_NEON)
+    const char* path = "NEON";
+#else
+    const char* path = "scalar";
+#endif
+    double blockUs = AUDIO_MAX_BLOCK_SAMPLES * 1000000.0 / AUDIO_SAMPLE_RATE;
+    printf("mixer (%s): %d-sample blocks, %.1f ms of audio each\n", path, AUDIO_MAX_BLOCK_SAMPLES, blockUs / 1000.0);
+
+    for(int c = 0; c < (int)(sizeof(voiceCounts) / sizeof(voiceCounts[0])); c++) {
+        int voices = voiceCounts[c];
+        uint64_t total = 0;
+        for(int run = 0; run < RUNS; run++) {
+            mixerInit();
+            for(int v = 0; v < voices; v++) mixerPlay(&sample, 0.5f, (v % 3) - 1.0f, 1);
+            uint64_t start = platformWallTimeUs();
+            for(int b = 0; b < SOURCE_BLOCKS; b++) mixerRender(out, music, AUDIO_MAX_BLOCK_SAMPLES);
+            total += platformWallTimeUs() - start;
+        }
+        double us = (double)total / (RUNS * SOURCE_BLOCKS);
+        printf("  %2d voices: %8.2f us/block  %6.3f%% of real time\n", voices, us, us / blockUs * 100.0);
+    }
+    return 0;
+}
+
+// Bullet-vs-enemy collision through the broadphase grid against the
+// brute-force scan it replaces, at growing entity counts. Entities sit in the
+// game's 6x2 spawn cross-section at about its density with the default caps,
+// the field stretching along z as counts grow. Both must find the same first
+// hit for every bullet. Returns the number of disagreements
+static int benchmarkCollision(void) {
+    static const int counts[] = {15, 50, 100, 150, 200, 300, 500, 1000, 10000};
+    enum { MAX_COUNT = 10000, TARGET_US = 200000 };
+    static float ex[MAX_COUNT], ey[MAX_COUNT], ez[MAX_COUNT], bx[MAX_COUNT], by[MAX_COUNT], bz[MAX_COUNT];
+    static int candidates[MAX_COUNT], gridHits[MAX_COUNT], bruteHits[MAX_COUNT];
+    const float r2 = 0.5f;
+    unsigned int seed = 2024;
+    int mismatches = 0;
+
+    printf("collision: bullets against enemies, first hit within sqrt(%.1f)\n", r2);
+    for(int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        int n = counts[c];
+        float depth = 10 + n / 3.0f;
+        for(int i = 0; i < n; i++) {
+            ex[i] = randomFloat(&seed, -3, 3);
+            ey[i] = randomFloat(&seed, -1, 1);
+            ez[i] = randomFloat(&seed, -depth, 0);
+            bx[i] = randomFloat(&seed, -3, 3);
+            by[i] = randomFloat(&seed, -1, 1);
+            bz[i] = randomFloat(&seed, -depth, 0);
+        }
+
+        // Sized the way the game's arena sizes its grids
+        SpatialGrid grid;
+        unsigned int buckets = 64;
+        while(buckets < (unsigned int)n * 2) buckets <<= 1;
+        grid.bucketMask = buckets - 1;
+        grid.start = (int*)malloc((buckets + 1) * sizeof(int));
+        grid.cursor = (int*)malloc(buckets * sizeof(int));
+        grid.items = (int*)malloc(n * sizeof(int));
+        grid.bucketOf = (unsigned int*)malloc(n * sizeof(unsigned int));
+
+        int gridRuns = 0, bruteRuns = 0;
+        uint64_t gridUs = 0, bruteUs = 0;
+        while(gridUs < TARGET_US) {
+            uint64_t start = platformWallTimeUs();
+            gridBuild(&grid, ex, ey, ez, n);
+            for(int b = 0; b < n; b++) {
+                int found = gridQuery(&grid, bx[b], by[b], bz[b], candidates), hit = -1;
+                for(int k = 0; k < found && hit < 0; k++) {
+                    int j = candidates[k];
+                    float dx = bx[b] - ex[j], dy = by[b] - ey[j], dz = bz[b] - ez[j];
+                    if(dx * dx + dy * dy + dz * dz < r2) hit = j;
+                }
+                gridHits[b] = hit;
+            }
+            gridUs += platformWallTimeUs() - start;
+            gridRuns++;
+        }
+        while(bruteUs < TARGET_US) {
+            uint64_t start = platformWallTimeUs();
+            for(int b = 0; b < n; b++) {
+                int hit = -1;
+                for(int j = 0; j < n && hit < 0; j++) {
+                    float dx = bx[b] - ex[j], dy = by[b] - ey[j], dz = bz[b] - ez[j];
+                    if(dx * dx + dy * dy + dz * dz < r2) hit = j;
+                }
+                bruteHits[b] = hit;
+            }
+            bruteUs += platformWallTimeUs() - start;
+            bruteRuns++;
+        }
+
+        int hits = 0, wrong = 0;
+        for(int b = 0; b < n; b++) {
+            hits += gridHits[b] >= 0;
+            wrong += gridHits[b] != bruteHits[b];
+        }
+        mismatches += wrong;
+        double g = (double)gridUs / gridRuns, bf = (double)bruteUs / bruteRuns;
+        printf("  %5d each over %6.0f z: grid %10.1f us  brute force %10.1f us  (%.1fx)  %d hits  %d mismatches  game uses %s\n",
+               n, depth, g, bf, g > 0 ? bf / g : 0.0, hits, wrong, collisionUsesGrid(n) ? "grid" : "brute force");
+        free(grid.start); free(grid.cursor); free(grid.items); free(grid.bucketOf);
+    }
+    return mismatches;
+}
+
+// Entity records as they were before structure-of-arrays storage: an active
+// flag among the fields, tested by every pass
+typedef struct {
+    float x, y, z;
+    int active;
+} AosBullet;
+
+typedef struct {
+    float x, y, z, vx, vy, vz;
+    int life, active;
+    unsigned int color;
+} AosParticle;
+
+// Bullet and particle movement through the old record layout and loops
+// against updateGame's kernels over the packed arrays, at growing counts.
+// Every entity is live and none expire, which spares the old layout the dead
+// slots it used to skip. The packed pools come from createGame, as the
+// kernels require
+static int benchmarkMovement(void) {
+    static const int counts[] = {1000, 10000, 100000};
+    enum { MAX_COUNT = 100000, TARGET_US = 200000 };
+    AosBullet* aosBullets = (AosBullet*)malloc(MAX_COUNT * sizeof(AosBullet));
+    AosParticle* aosParticles = (AosParticle*)malloc(MAX_COUNT * sizeof(AosParticle));
+    Capacities caps = {MAX_COUNT, 1, 1, MAX_COUNT};
+    Arena arena;
+    Game* g = createGame(&arena, &caps);
+    if(!aosBullets || !aosParticles || !g) platformFatal("Out of memory for --bench-movement");
+    Bullets* b = &g->bullets;
+    Particles* p = &g->particles;
+    unsigned int seed = 99;
+
+    printf("movement: old records with active flags against packed arrays, ns per entity per tick\n");
+    for(int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        int n = counts[c];
+        for(int i = 0; i < n; i++) {
+            float vx = randomFloat(&seed, -0.5f, 0.5f), vy = randomFloat(&seed, -0.5f, 0.5f);
+            float vz = randomFloat(&seed, -0.5f, 0.5f);
+            aosBullets[i] = (AosBullet){0, 0, 0, 1};
+            aosParticles[i] = (AosParticle){0, 0, 0, vx, vy, vz, 1 << 30, 1, 0xFFFFFFFF};
+            b->z[i] = 0;
+            p->x[i] = p->y[i] = p->z[i] = 0;
+            p->vx[i] = vx; p->vy[i] = vy; p->vz[i] = vz;
+            p->life[i] = 1 << 30;
+        }
+        b->pool.count = p->pool.count = n;
+
+        double ns[4];
+        for(int k = 0; k < 4; k++) {
+            int runs = 0, expired = 0;
+            uint64_t elapsed = 0;
+            while(elapsed < TARGET_US) {
+                uint64_t start = platformWallTimeUs();
+                if(k == 0) {
+                    for(int i = 0; i < n; i++) {
+                        if(aosBullets[i].active) {
+                            aosBullets[i].z -= 0.3f;
+                            if(aosBullets[i].z < -1e30f) aosBullets[i].active = 0;
+                        }
+                    }
+                } else if(k == 1) {
+                    moveBullets(b);
+                    for(int i = 0; i < n; i++) expired += b->z[i] < -1e30f;
+                } else if(k == 2) {
+                    for(int i = 0; i < n; i++) {
+                        AosParticle* a = &aosParticles[i];
+                        if(a->active) {
+                            a->x += a->vx;
+                            a->y += a->vy;
+                            a->z += a->vz;
+                            a->vy -= 0.01f;
+                            if(--a->life <= 0) a->active = 0;
+                        }
+                    }
+                } else {
+                    integrateParticles(p);
+                    for(int i = 0; i < n; i++) expired += p->life[i] <= 0;
+                }
+                elapsed += platformWallTimeUs() - start;
+                runs++;
+            }
+            if(expired) printf("unexpected expiry\n");
+            ns[k] = elapsed * 1000.0 / runs / n;
+        }
+        printf("  %6d: bullets %6.3f -> %6.3f (%.1fx)  particles %6.3f -> %6.3f (%.1fx)\n",
+               n, ns[0], ns[1], ns[0] / ns[1], ns[2], ns[3], ns[2] / ns[3]);
+    }
+
+    free(aosBullets); free(aosParticles); free(arena.base);
+    return 0;
+}
+
+// Audio queue stress: one thread pushes numbered commands as fast as it can,
+// retrying when the ring is full, while another pops them. Every command must
+// arrive exactly once, in order, with its payload intact. Both sides yield
+// when they cannot make progress, so it also finishes on a single core
+#define STRESS_COMMANDS 20000000u
+
+static AudioQueue stressQueue;
+
+static AudioCommand stressCommand(unsigned int n) {
+    AudioCommand c = {(AudioCommandType)(n % 4), (int)(n % 7), (int)(n >> 3), (int)n,
+                      (float)(n & 0xFFFF), -(float)(n & 0xFF)};
+    return c;
+}
+
+static void* stressProducer(void* arg) {
+    unsigned int* fullSpins = (unsigned int*)arg;
+    for(unsigned int n = 0; n < STRESS_COMMANDS; ) {
+        AudioCommand c = stressCommand(n);
+        if(audioQueuePush(&stressQueue, &c) == 0) n++;
+        else { (*fullSpins)++; sched_yield(); }
+    }
+    return NULL;
+}
+
+static int stressAudioQueue(void) {
+    audioQueueInit(&stressQueue);
+    unsigned int fullSpins = 0, errors = 0, emptySpins = 0;
+    uint64_t start = platformWallTimeUs();
+
+    pthread_t producer;
+    if(pthread_create(&producer, NULL, stressProducer, &fullSpins) != 0) return 1;
+    for(unsigned int n = 0; n < STRESS_COMMANDS; ) {
+        AudioCommand c;
+        if(!audioQueuePop(&stressQueue, &c)) { emptySpins++; sched_yield(); continue; }
+        AudioCommand want = stressCommand(n);
+        if(memcmp(&c, &want, sizeof(c)) != 0 && errors++ < 10)
+            fprintf(stderr, "command %u: got value %d\n", n, c.value);
+        n++;
+    }
+    pthread_join(producer, NULL);
+
+    double seconds = (platformWallTimeUs() - start) / 1000000.0;
+    printf("audio queue: %u commands in %.2f s (%.1f M/s), %u full, %u empty polls, %u errors\n",
+           STRESS_COMMANDS, seconds, seconds > 0 ? STRESS_COMMANDS / seconds / 1e6 : 0.0,
+           fullSpins, emptySpins, errors);
+    return errors != 0;
+}
+
+// Column-major 4x4 matrices, built the way sceGumPerspective and
+// sceGumLookAt build theirs, independently of the frustum planes
+static void perspective(float m[16], float fovDegrees, float aspect, float zNear, float zFar) {
+    float f = 1.0f / tanf(fovDegrees * 3.14159265f / 360.0f);
+    memset(m, 0, 16 * sizeof(float));
+    m[0] = f / aspect;
+    m[5] = f;
+    m[10] = (zFar + zNear) / (zNear - zFar);
+    m[11] = -1;
+    m[14] = 2 * zFar * zNear / (zNear - zFar);
+}
+
+static void lookAt(float m[16], const float eye[3], const float center[3], const float up[3]) {
+    float f[3] = {center[0] - eye[0], center[1] - eye[1], center[2] - eye[2]};
+    float fl = sqrtf(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    for(int i = 0; i < 3; i++) f[i] /= fl;
+    float s[3] = {f[1] * up[2] - f[2] * up[1], f[2] * up[0] - f[0] * up[2], f[0] * up[1] - f[1] * up[0]};
+    float sl = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    for(int i = 0; i < 3; i++) s[i] /= sl;
+    float u[3] = {s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0]};
+    memset(m, 0, 16 * sizeof(float));
+    for(int i = 0; i < 3; i++) {
+        m[i * 4 + 0] = s[i];
+        m[i * 4 + 1] = u[i];
+        m[i * 4 + 2] = -f[i];
+    }
+    m[12] = -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]);
+    m[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+    m[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+    m[15] = 1;
+}
+
+static void multiply(float out[16], const float a[16], const float b[16]) {
+    for(int c = 0; c < 4; c++)
+        for(int r = 0; r < 4; r++) {
+            float sum = 0;
+            for(int k = 0; k < 4; k++) sum += a[k * 4 + r] * b[c * 4 + k];
+            out[c * 4 + r] = sum;
+        }
+}
+
+// Inside the clip volume, by a hair's margin so points on an edge are not
+// argued over
+static int projectsInside(const float m[16], const float p[3]) {
+    float clip[4];
+    for(int r = 0; r < 4; r++) clip[r] = m[r] * p[0] + m[4 + r] * p[1] + m[8 + r] * p[2] + m[12 + r];
+    float w = clip[3] * (1 - 1e-4f);
+    return w > 0 && fabsf(clip[0]) <= w && fabsf(clip[1]) <= w && fabsf(clip[2]) <= w;
+}
+
+// The radii against the shapes themselves: entities placed around the game
+// camera's view, and every vertex of each one that gets culled projected to
+// make sure none of it was on screen. Enemies are turned as they are drawn.
+// Returns the errors
+static int checkCulledShapes(unsigned int* seed, int* culled) {
+    enum { CAMERAS = 100, ENTITIES = 5000 };
+    static struct Vertex baked[MESH_VERTEX_CAPACITY];
+    MeshRange ranges[MESH_COUNT];
+    meshBake(baked, MESH_VERTEX_CAPACITY, ranges);
+    int errors = 0;
+
+    for(int c = 0; c < CAMERAS; c++) {
+        float eye[3], center[3], up[3] = {0, 1, 0};
+        cameraView(randomFloat(seed, -3, 3), randomFloat(seed, -1.5f, 1.5f), 0, eye, center);
+        Frustum f;
+        frustumBuild(&f, CAMERA_FOV, CAMERA_ASPECT, CAMERA_NEAR, CAMERA_FAR, eye, center, up);
+        float projection[16], view[16], m[16];
+        perspective(projection, CAMERA_FOV, CAMERA_ASPECT, CAMERA_NEAR, CAMERA_FAR);
+        lookAt(view, eye, center, up);
+        multiply(m, projection, view);
+
+        for(int n = 0; n < ENTITIES; n++) {
+            float p[3] = {randomFloat(seed, -40, 40), randomFloat(seed, -20, 20), randomFloat(seed, -60, 6)};
+            int kind = n % 3;
+            float radius = kind == 0 ? cullEnemyRadius() : kind == 1 ? CULL_BULLET_RADIUS : CULL_PARTICLE_RADIUS;
+            if(frustumSphere(&f, p[0], p[1], p[2], radius)) continue;
+            (*culled)++;
+
+            // Enemy mesh turned by a random angle, a bullet cube, or a spark's corners
+            MeshId mesh = kind == 0 ? (MeshId)(MESH_ENEMY_BASIC + n / 3 % (MESH_ENEMY_SPEEDSTER - MESH_ENEMY_BASIC + 1)) : MESH_CUBE_YELLOW;
+            float angle = randomFloat(seed, 0, 6.2831853f), scale = kind == 1 ? 0.08f : 1;
+            float sparkCorners[2][3] = {{-0.06f, 0.06f, 0}, {0.06f, -0.06f, 0}};
+            int count = kind == 2 ? 2 : ranges[mesh].count;
+            for(int i = 0; i < count; i++) {
+                float v[3];
+                if(kind == 2) {
+                    memcpy(v, sparkCorners[i], sizeof(v));
+                } else {
+                    const struct Vertex* b = &baked[ranges[mesh].first + i];
+                    float cs = kind == 0 ? cosf(angle) : 1, sn = kind == 0 ? sinf(angle) : 0;
+                    v[0] = (b->x * cs + b->z * sn) * scale;
+                    v[1] = b->y * scale;
+                    v[2] = (b->z * cs - b->x * sn) * scale;
+                }
+                float q[3] = {p[0] + v[0], p[1] + v[1], p[2] + v[2]};
+                if(projectsInside(m, q)) {
+                    errors++;
+                    if(errors <= 5)
+                        printf("culled %s but vertex %d on screen at (%.2f %.2f %.2f)\n",
+                               kind == 0 ? "enemy" : kind == 1 ? "bullet" : "spark", i, q[0], q[1], q[2]);
+                    break;
+                }
+            }
+        }
+    }
+    return errors;
+}
+
+// Random spheres around game and random cameras, each culled or kept by the
+// frustum and then projected point by point through the camera's matrices. A
+// culled sphere with any point on screen is an error. A kept sphere with none
+// is a conservative keep, which the sphere test allows near the corners
+static int checkCulling(void) {
+    enum { CAMERAS = 200, SPHERES = 2000, SAMPLES = 64 };
+    unsigned int seed = 12345;
+    int culled = 0, kept = 0, conservative = 0, errors = 0;
+
+    for(int c = 0; c < CAMERAS; c++) {
+        float eye[3], center[3], up[3] = {0, 1, 0};
+        float fov = CAMERA_FOV, aspect = CAMERA_ASPECT, zNear = CAMERA_NEAR, zFar = CAMERA_FAR;
+        if(c < CAMERAS / 2) {
+            // The game's own camera over the playfield
+            cameraView(randomFloat(&seed, -3, 3), randomFloat(&seed, -1.5f, 1.5f), 0, eye, center);
+        } else {
+            for(int i = 0; i < 3; i++) {
+                eye[i] = randomFloat(&seed, -10, 10);
+                center[i] = eye[i] + randomFloat(&seed, -1, 1);
+            }
+            up[0] = randomFloat(&seed, -0.3f, 0.3f);
+            fov = randomFloat(&seed, 30, 100);
+            aspect = randomFloat(&seed, 1, 2);
+            zFar = randomFloat(&seed, 20, 200);
+        }
+        Frustum f;
+        frustumBuild(&f, fov, aspect, zNear, zFar, eye, center, up);
+        float projection[16], view[16], m[16];
+        perspective(projection, fov, aspect, zNear, zFar);
+        lookAt(view, eye, center, up);
+        multiply(m, projection, view);
+
+        for(int n = 0; n < SPHERES; n++) {
+            float p[3], r = randomFloat(&seed, 0.05f, 2);
+            for(int i = 0; i < 3; i++) p[i] = eye[i] + randomFloat(&seed, -zFar * 0.6f, zFar * 0.6f);
+            int visible = frustumSphere(&f, p[0], p[1], p[2], r);
+
+            int onScreen = projectsInside(m, p);
+            for(int k = 0; k < SAMPLES && !onScreen; k++) {
+                float d[3] = {randomFloat(&seed, -1, 1), randomFloat(&seed, -1, 1), randomFloat(&seed, -1, 1)};
+                float l = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+                if(l == 0 || l > 1) { k--; continue; }
+                float reach = (k % 2) ? r : r * l;   // Every other sample on the surface
+                float q[3] = {p[0] + d[0] / l * reach, p[1] + d[1] / l * reach, p[2] + d[2] / l * reach};
+                onScreen = projectsInside(m, q);
+            }
+
+            if(visible) {
+                kept++;
+                if(!onScreen) conservative++;
+            } else {
+                culled++;
+                if(onScreen) {
+                    errors++;
+                    if(errors <= 5)
+                        printf("culled but on screen: camera %d sphere (%.2f %.2f %.2f) r %.2f\n",
+                               c, p[0], p[1], p[2], r);
+                }
+            }
+        }
+    }
+
+    printf("culling: %d spheres, %d culled, %d kept (%d of them conservatively), %d errors\n",
+           culled + kept, culled, kept, conservative, errors);
+
+    int shapesCulled = 0;
+    int shapeErrors = checkCulledShapes(&seed, &shapesCulled);
+    printf("culling: %d culled entities checked vertex by vertex (enemy radius %.3f), %d errors\n",
+           shapesCulled, cullEnemyRadius(), shapeErrors);
+    return errors + shapeErrors != 0;
+}
+
+// The shapes as the renderer used to build them in list memory every frame,
+// before the mesh registry: cubes at their drawn size, the rest as emitted
+static int oldCube(struct Vertex* v, float s, unsigned int color) {
+    static const signed char faces[36][3] = {
+        {-1,-1, 1}, { 1,-1, 1}, { 1, 1, 1}, {-1,-1, 1}, { 1, 1, 1}, {-1, 1, 1},   // Front
+        { 1,-1,-1}, {-1,-1,-1}, {-1, 1,-1}, { 1,-1,-1}, {-1, 1,-1}, { 1, 1,-1},   // Back
+        {-1, 1, 1}, { 1, 1, 1}, { 1, 1,-1}, {-1, 1, 1}, { 1, 1,-1}, {-1, 1,-1},   // Top
+        {-1,-1,-1}, { 1,-1,-1}, { 1,-1, 1}, {-1,-1,-1}, { 1,-1, 1}, {-1,-1, 1},   // Bottom
+        {-1,-1,-1}, {-1,-1, 1}, {-1, 1, 1}, {-1,-1,-1}, {-1, 1, 1}, {-1, 1,-1},   // Left
+        { 1,-1, 1}, { 1,-1,-1}, { 1, 1,-1}, { 1,-1, 1}, { 1, 1,-1}, { 1, 1, 1}    // Right
+    };
+    for(int i = 0; i < 36; i++) {
+        v[i].color = color;
+        v[i].x = faces[i][0] * s; v[i].y = faces[i][1] * s; v[i].z = faces[i][2] * s;
+    }
+    return 36;
+}
+
+static const struct Vertex oldWings[] = {
+    {0xFF0080FF, -0.6f, 0, 0}, {0xFF0080FF, -0.2f, 0, -0.2f}, {0xFF0080FF, -0.2f, 0, 0.2f},
+    {0xFF0080FF, 0.6f, 0, 0}, {0xFF0080FF, 0.2f, 0, 0.2f}, {0xFF0080FF, 0.2f, 0, -0.2f}
+};
+static const struct Vertex oldBasic[] = {
+    {0xFF0000FF, 0, 0.4f, 0}, {0xFF0000FF, -0.4f, -0.4f, 0}, {0xFF0000FF, 0.4f, -0.4f, 0}
+};
+static const struct Vertex oldZigzag[] = {
+    {0xFFFF00FF, 0, 0.4f, 0}, {0xFFFF00FF, -0.3f, 0, 0}, {0xFFFF00FF, 0, -0.4f, 0},
+    {0xFFFF00FF, 0, 0.4f, 0}, {0xFFFF00FF, 0, -0.4f, 0}, {0xFFFF00FF, 0.3f, 0, 0}
+};
+static const struct Vertex oldCircler[] = {
+    {0xFF00FF00, -0.4f, -0.4f, 0}, {0xFF00FF00, -0.2f, -0.2f, 0}, {0xFF00FF00, 0.4f, 0.4f, 0},
+    {0xFF00FF00, -0.2f, -0.2f, 0}, {0xFF00FF00, 0.4f, 0.4f, 0}, {0xFF00FF00, 0.2f, 0.2f, 0},
+    {0xFF00FF00, 0.4f, -0.4f, 0}, {0xFF00FF00, 0.2f, -0.2f, 0}, {0xFF00FF00, -0.4f, 0.4f, 0},
+    {0xFF00FF00, 0.2f, -0.2f, 0}, {0xFF00FF00, -0.4f, 0.4f, 0}, {0xFF00FF00, -0.2f, 0.2f, 0}
+};
+static const struct Vertex oldShooter[] = {
+    {0xFF0088FF, -0.3f, 0.3f, 0}, {0xFF0088FF, 0.3f, 0.3f, 0}, {0xFF0088FF, 0.3f, -0.3f, 0},
+    {0xFF0088FF, -0.3f, 0.3f, 0}, {0xFF0088FF, 0.3f, -0.3f, 0}, {0xFF0088FF, -0.3f, -0.3f, 0},
+    {0xFFFFFFFF, 0, 0.2f, 0}, {0xFFFFFFFF, -0.15f, -0.1f, 0}, {0xFFFFFFFF, 0.15f, -0.1f, 0},
+    {0xFFFFFFFF, 0, 0, 0.05f}, {0xFFFFFFFF, 0.05f, 0, 0}, {0xFFFFFFFF, 0, 0.05f, 0}
+};
+// Drawn as twelve vertices and then a mirror of six
+static const struct Vertex oldTank[] = {
+    {0xFFFFAA00, 0, 0, 0}, {0xFFFFAA00, 0, 0.5f, 0}, {0xFFFFAA00, 0.4f, 0.25f, 0},
+    {0xFFFFAA00, 0, 0, 0}, {0xFFFFAA00, 0.4f, 0.25f, 0}, {0xFFFFAA00, 0.4f, -0.25f, 0},
+    {0xFFFFAA00, 0, 0, 0}, {0xFFFFAA00, 0.4f, -0.25f, 0}, {0xFFFFAA00, 0, -0.5f, 0},
+    {0xFFFFAA00, 0, 0, 0}, {0xFFFFAA00, 0, -0.5f, 0}, {0xFFFFAA00, -0.4f, -0.25f, 0},
+    {0xFFFFAA00, 0, 0, 0}, {0xFFFFAA00, -0.4f, -0.25f, 0}, {0xFFFFAA00, -0.4f, 0.25f, 0},
+    {0xFFFFAA00, 0, 0, 0}, {0xFFFFAA00, -0.4f, 0.25f, 0}, {0xFFFFAA00, 0, 0.5f, 0}
+};
+static const struct Vertex oldSpeedster[] = {
+    {0xFF00FFFF, 0, 0.35f, 0}, {0xFF00FFFF, -0.1f, 0.05f, 0}, {0xFF00FFFF, 0.1f, 0.05f, 0},
+    {0xFF00FFFF, -0.3f, -0.2f, 0}, {0xFF00FFFF, -0.05f, -0.05f, 0}, {0xFF00FFFF, 0, 0, 0},
+    {0xFF00FFFF, 0.3f, -0.2f, 0}, {0xFF00FFFF, 0, 0, 0}, {0xFF00FFFF, 0.05f, -0.05f, 0}
+};
+
+// Every registry mesh, baked and then packed as the GE reads it, against the
+// shapes it replaced. Cubes are baked at unit size and scaled by the model
+// matrix, so they are compared at the size each was drawn. Baked vertices must
+// match exactly; packed ones to within half a step of position and color
+static int checkMeshes(void) {
+    static const struct { MeshId id; float size; } cubes[] = {
+        {MESH_CUBE_WHITE, 0.25f}, {MESH_CUBE_YELLOW, 0.08f}, {MESH_CUBE_BLUE, 0.08f}
+    };
+    static const unsigned int cubeColors[] = {0xFFDDDDDD, 0xFF00FFFF, 0xFFFF0000};
+    static const struct { MeshId id; const struct Vertex* v; int count; } shapes[] = {
+        {MESH_PLAYER_WINGS, oldWings, 6}, {MESH_ENEMY_BASIC, oldBasic, 3},
+        {MESH_ENEMY_ZIGZAG, oldZigzag, 6}, {MESH_ENEMY_CIRCLER, oldCircler, 12},
+        {MESH_ENEMY_SHOOTER, oldShooter, 12}, {MESH_ENEMY_TANK, oldTank, 18},
+        {MESH_ENEMY_SPEEDSTER, oldSpeedster, 9}
+    };
+    static struct Vertex baked[MESH_VERTEX_CAPACITY];
+    static struct PackedVertex packed[MESH_VERTEX_CAPACITY];
+    MeshRange ranges[MESH_COUNT];
+    int total = meshBake(baked, MESH_VERTEX_CAPACITY, ranges);
+    if(total < 0 || meshPack(baked, packed, total, MESH_POSITION_SCALE) != 0) {
+        printf("meshes: registry does not bake or pack\n");
+        return 1;
+    }
+
+    int errors = 0, checked = 0, compared = 0;
+    float worstPosition = 0;
+    int worstColor = 0;
+    for(int n = 0; n < (int)(sizeof(cubes) / sizeof(cubes[0])) + (int)(sizeof(shapes) / sizeof(shapes[0])); n++) {
+        struct Vertex cube[36];
+        MeshId id;
+        const struct Vertex* old;
+        int count;
+        float size;
+        if(n < 3) {
+            id = cubes[n].id; size = cubes[n].size;
+            count = oldCube(cube, size, cubeColors[n]);
+            old = cube;
+        } else {
+            id = shapes[n - 3].id; size = 1;
+            old = shapes[n - 3].v; count = shapes[n - 3].count;
+        }
+        compared++;
+        if(ranges[id].count != count) {
+            printf("mesh %d: %d vertices, was %d\n", id, ranges[id].count, count);
+            errors++;
+            continue;
+        }
+
+        for(int i = 0; i < count; i++) {
+            const struct Vertex* b = &baked[ranges[id].first + i];
+            const struct PackedVertex* p = &packed[ranges[id].first + i];
+            const struct Vertex* o = &old[i];
+            checked++;
+            if(b->color != o->color || b->x * size != o->x || b->y * size != o->y || b->z * size != o->z) {
+                if(errors++ < 5) printf("mesh %d vertex %d: baked differs from the old shape\n", id, i);
+                continue;
+            }
+
+            // Packed position through the model matrix scale, and the 5650
+            // color widened back to eight bits
+            float k = MESH_POSITION_SCALE / 32768.0f * size;
+            float d[3] = {p->x * k - o->x, p->y * k - o->y, p->z * k - o->z};
+            for(int a = 0; a < 3; a++) if(fabsf(d[a]) > worstPosition) worstPosition = fabsf(d[a]);
+            int r = ((p->color & 31) * 255 + 15) / 31, g = ((p->color >> 5 & 63) * 255 + 31) / 63;
+            int bl = ((p->color >> 11) * 255 + 15) / 31;
+            int dc[3] = {abs(r - (int)(o->color & 0xFF)), abs(g - (int)(o->color >> 8 & 0xFF)),
+                         abs(bl - (int)(o->color >> 16 & 0xFF))};
+            for(int a = 0; a < 3; a++) if(dc[a] > worstColor) worstColor = dc[a];
+            if(fabsf(d[0]) > k || fabsf(d[1]) > k || fabsf(d[2]) > k || dc[0] > 4 || dc[1] > 2 || dc[2] > 4) {
+                if(errors++ < 5) printf("mesh %d vertex %d: packed vertex too far from the old shape\n", id, i);
+            }
+        }
+    }
+
+    printf("meshes: %d meshes, %d vertices against the per-frame shapes, worst packed error %.6f position, "
+           "%d color levels, %d errors\n", compared, checked, worstPosition, worstColor, errors);
+    return errors != 0;
+}
+
+// Morphed height of one template vertex for a row whose phase has cosine c
+// and sine s, as the GE blends it
+static float terrainHeight(const TerrainLod* lod, int line, int column, float c, float s) {
+    const TerrainVertex* v = &lod->vertices[line * (lod->columns + 1) + column];
+    float y = v->frame[0].y * (1 - c - s) + v->frame[1].y * c + v->frame[2].y * s;
+    return y * TERRAIN_SCALE_Y / 32768.0f;
+}
+
+// Height gap along the seam between a row and the next one back: the finer
+// edge at each of its columns against the coarser edge between its columns
+static float seamGap(const TerrainLod* lods, const TerrainRow* nearRow, const TerrainRow* farRow, float time) {
+    float nearPhase = terrainPhase(time, nearRow->z), farPhase = terrainPhase(time, farRow->z);
+    const TerrainLod* nearLod = &lods[nearRow->lod];
+    const TerrainLod* farLod = &lods[farRow->lod];
+    int nearFiner = nearRow->lod <= farRow->lod;
+    const TerrainLod* fine = nearFiner ? nearLod : farLod;
+    const TerrainLod* coarse = nearFiner ? farLod : nearLod;
+    float fineC = cosf(nearFiner ? nearPhase : farPhase), fineS = sinf(nearFiner ? nearPhase : farPhase);
+    float coarseC = cosf(nearFiner ? farPhase : nearPhase), coarseS = sinf(nearFiner ? farPhase : nearPhase);
+    // The near row meets the far one along its last grid line
+    int fineLine = nearFiner ? fine->rows : 0, coarseLine = nearFiner ? 0 : coarse->rows;
+    int ratio = fine->columns / coarse->columns;
+
+    float worst = 0;
+    for(int i = 0; i <= fine->columns; i++) {
+        int left = i / ratio, right = left < coarse->columns ? left + 1 : left;
+        float t = (float)(i - left * ratio) / ratio;
+        float h = terrainHeight(fine, fineLine, i, fineC, fineS);
+        float hc = terrainHeight(coarse, coarseLine, left, coarseC, coarseS) * (1 - t) +
+                   terrainHeight(coarse, coarseLine, right, coarseC, coarseS) * t;
+        if(fabsf(h - hc) > worst) worst = fabsf(h - hc);
+    }
+    return worst;
+}
+
+// The rows of chunks over a minute of play at each terrain detail setting, from
+// the game camera: vertices and draws per frame, and the widest height gap
+// at any seam between rows, which fails the check if the skirts cannot cover
+// it. The old ground was a 16x16 grid of quads drawn one call each
+static int checkTerrain(void) {
+    static TerrainVertex vertices[TERRAIN_VERTS];
+    static unsigned short indices[TERRAIN_INDICES];
+    static const char* names[TERRAIN_DETAIL_COUNT] = {"low", "medium", "high"};
+    enum { FRAMES = 3600 };
+    TerrainLod lods[TERRAIN_LODS];
+    terrainBuild(vertices, indices, lods);
+
+    float eye[3], center[3];
+    cameraView(0, 0, 0, eye, center);
+    printf("terrain: %d rows of %.0fx%.0f chunks; LOD vertices", TERRAIN_ROWS,
+           TERRAIN_CHUNK_WIDTH, TERRAIN_CHUNK_DEPTH);
+    for(int l = 0; l < TERRAIN_LODS; l++) printf(" %d", lods[l].indexCount);
+    printf(" (%dx%d to %dx%d cells); was 1536 vertices in 256 draws\n", lods[0].columns, lods[0].rows,
+           lods[TERRAIN_LODS - 1].columns, lods[TERRAIN_LODS - 1].rows);
+
+    int failed = 0;
+    for(int detail = 0; detail < TERRAIN_DETAIL_COUNT; detail++) {
+        long total = 0;
+        int least = 1 << 30, most = 0, uses[TERRAIN_LODS] = {0};
+        float worstGap = 0;
+        for(int f = 0; f < FRAMES; f++) {
+            float time = f * SIM_DT;
+            TerrainRow rows[TERRAIN_ROWS];
+            terrainRows(time, eye[2], detail, rows);
+            int count = 0;
+            for(int n = 0; n < TERRAIN_ROWS; n++) {
+                count += lods[rows[n].lod].indexCount;
+                uses[rows[n].lod]++;
+                if(n + 1 < TERRAIN_ROWS) {
+                    float gap = seamGap(lods, &rows[n], &rows[n + 1], time);
+                    if(gap > worstGap) worstGap = gap;
+                }
+            }
+            total += count;
+            if(count < least) least = count;
+            if(count > most) most = count;
+        }
+        if(worstGap > TERRAIN_SKIRT_DEPTH) failed = 1;
+        printf("  %-6s %5ld vertices/frame avg (%d-%d) in %d draws | rows at LOD 0-3: %.1f %.1f %.1f %.1f"
+               " | seam gap %.3f of %.1f skirt\n",
+               names[detail], total / FRAMES, least, most, TERRAIN_ROWS,
+               (float)uses[0] / FRAMES, (float)uses[1] / FRAMES, (float)uses[2] / FRAMES, (float)uses[3] / FRAMES,
+               worstGap, TERRAIN_SKIRT_DEPTH);
+    }
+    return failed;
+}
+
+
+static const struct {
+    const char* flag;
+    int (*run)(void);
+} hostChecks[] = {
+    {"--bench-mixer", benchmarkMixer},
+    {"--bench-collision", benchmarkCollision},
+    {"--bench-movement", benchmarkMovement},
+    {"--stress-audio-queue", stressAudioQueue},
+    {"--check-culling", checkCulling},
+    {"--check-meshes", checkMeshes},
+    {"--check-terrain", checkTerrain}
+};
+
+int hostCheckRun(const char* flag) {
+    for(int i = 0; i < (int)(sizeof(hostChecks) / sizeof(hostChecks[0])); i++) {
+        if(strcmp(flag, hostChecks[i].flag) == 0) return hostChecks[i].run() != 0;
+    }
+    return -1;
+}
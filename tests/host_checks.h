@@ -0,0 +1,9 @@
+// Host-only checks and benchmarks for the headless Linux build
+#ifndef HOST_CHECKS_H
+#define HOST_CHECKS_H
+
+// Run the check or benchmark a command-line flag names, such as
+// --check-meshes. Returns its exit status, or -1 if the flag names none
+int hostCheckRun(const char* flag);
+
+#endif
@@ -0,0 +1,326 @@
+// Asset packer, built and run on the host: make assets.pak
+//
+//   pack-assets OUTPUT NAME=FILE...
+//
+// Packs each FILE under NAME, by extension: .wav as resident PCM, .ogg as a
+// streamed Vorbis track. The static meshes are baked in as "meshes", packed
+// to 16-bit positions and 5650 colors, with a table of the error that costs.
+// Every asset is checked against what the game expects, and any that does not
+// match fails the build instead of the game
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../assets.h"
+#include "../meshes.h"
+#include "../platform.h"
+
+#define MAX_ENTRIES 32
+
+typedef struct {
+    PakEntry entry;
+    unsigned char* data;
+    const char* source;
+} Asset;
+
+static Asset assets[MAX_ENTRIES];
+static int assetCount = 0;
+
+static void fail(const char* source, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "pack-assets: %s: ", source);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    exit(1);
+}
+
+static unsigned int le16(const unsigned char* p) { return p[0] | p[1] << 8; }
+static unsigned int le32(const unsigned char* p) { return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24; }
+
+static unsigned char* readFile(const char* path, long* size) {
+    FILE* f = fopen(path, "rb");
+    if(!f) fail(path, "cannot open");
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* data = (unsigned char*)malloc(*size > 0 ? *size : 1);
+    if(!data || fread(data, 1, *size, f) != (size_t)*size) fail(path, "cannot read");
+    fclose(f);
+    return data;
+}
+
+static Asset* addAsset(const char* name, PakType type, const char* source) {
+    if(assetCount == MAX_ENTRIES) fail(source, "more than %d assets", MAX_ENTRIES);
+    if(strlen(name) >= PAK_NAME_LENGTH) fail(source, "name '%s' longer than %d characters", name, PAK_NAME_LENGTH - 1);
+    for(int i = 0; i < assetCount; i++)
+        if(strcmp(assets[i].entry.name, name) == 0) fail(source, "name '%s' used twice", name);
+
+    Asset* a = &assets[assetCount++];
+    memset(a, 0, sizeof(*a));
+    strcpy(a->entry.name, name);
+    a->entry.type = type;
+    a->source = source;
+    return a;
+}
+
+// RIFF WAVE holding 16-bit stereo PCM at the output rate; only the samples
+// go into the archive
+static void packWav(const char* name, const char* path) {
+    long size;
+    unsigned char* file = readFile(path, &size);
+    if(size < 12 || memcmp(file, "RIFF", 4) != 0 || memcmp(file + 8, "WAVE", 4) != 0)
+        fail(path, "not a RIFF WAVE file");
+
+    const unsigned char* format = NULL;
+    const unsigned char* samples = NULL;
+    unsigned int sampleBytes = 0;
+    long at = 12;
+    while(at + 8 <= size) {
+        unsigned int chunkSize = le32(file + at + 4);
+        if(chunkSize > size - at - 8) fail(path, "chunk '%.4s' runs past the end of the file", file + at);
+        if(memcmp(file + at, "fmt ", 4) == 0 && chunkSize >= 16) format = file + at + 8;
+        if(memcmp(file + at, "data", 4) == 0) {
+            samples = file + at + 8;
+            sampleBytes = chunkSize;
+        }
+        at += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    if(!format) fail(path, "no fmt chunk");
+    if(!samples) fail(path, "no data chunk");
+    if(le16(format) != 1) fail(path, "format %u, only PCM (1) is played", le16(format));
+    if(le16(format + 2) != 2) fail(path, "%u channels, the mixer wants 2", le16(format + 2));
+    if(le32(format + 4) != AUDIO_SAMPLE_RATE) fail(path, "%u Hz, output runs at %d Hz", le32(format + 4), AUDIO_SAMPLE_RATE);
+    if(le16(format + 14) != 16) fail(path, "%u-bit samples, the mixer wants 16", le16(format + 14));
+    if(le16(format + 12) != 4) fail(path, "block align %u, expected 4", le16(format + 12));
+    if(sampleBytes == 0 || sampleBytes % 4 != 0) fail(path, "%u bytes of samples is not whole frames", sampleBytes);
+
+    Asset* a = addAsset(name, PAK_PCM, path);
+    a->data = (unsigned char*)malloc(sampleBytes);
+    memcpy(a->data, samples, sampleBytes);
+    a->entry.size = sampleBytes;
+    a->entry.info = sampleBytes / 4;
+    free(file);
+}
+
+static unsigned int oggCrc(const unsigned char* data, long size) {
+    static unsigned int table[256];
+    if(!table[1]) {
+        for(unsigned int i = 0; i < 256; i++) {
+            unsigned int r = i << 24;
+            for(int b = 0; b < 8; b++) r = (r & 0x80000000u) ? (r << 1) ^ 0x04C11DB7u : r << 1;
+            table[i] = r;
+        }
+    }
+    unsigned int crc = 0;
+    for(long i = 0; i < size; i++) crc = (crc << 8) ^ table[((crc >> 24) ^ data[i]) & 0xFF];
+    return crc;
+}
+
+// One logical Ogg stream of whole, checksummed pages, starting with a Vorbis
+// identification header for stereo at the output rate
+static void packOgg(const char* name, const char* path) {
+    long size;
+    unsigned char* file = readFile(path, &size);
+
+    long at = 0;
+    int pages = 0;
+    unsigned int serial = 0;
+    int ended = 0;
+    while(at < size) {
+        const unsigned char* page = file + at;
+        if(size - at < 27 || memcmp(page, "OggS", 4) != 0) fail(path, "no Ogg page at byte %ld", at);
+        if(ended) fail(path, "data after the end-of-stream page");
+        if(page[4] != 0) fail(path, "Ogg version %u at byte %ld", page[4], at);
+
+        int segments = page[26];
+        if(size - at < 27 + segments) fail(path, "page at byte %ld is cut short", at);
+        long pageSize = 27 + segments;
+        for(int i = 0; i < segments; i++) pageSize += page[27 + i];
+        if(pageSize > size - at) fail(path, "page at byte %ld is cut short", at);
+
+        unsigned int stored = le32(page + 22);
+        unsigned char* crcField = file + at + 22;
+        memset(crcField, 0, 4);
+        unsigned int crc = oggCrc(page, pageSize);
+        crcField[0] = stored; crcField[1] = stored >> 8; crcField[2] = stored >> 16; crcField[3] = stored >> 24;
+        if(crc != stored) fail(path, "bad checksum on the page at byte %ld", at);
+
+        if(pages == 0) {
+            const unsigned char* packet = page + 27 + segments;
+            serial = le32(page + 14);
+            if(!(page[5] & 0x02)) fail(path, "first page does not begin the stream");
+            if(pageSize - 27 - segments < 30 || memcmp(packet, "\x01vorbis", 7) != 0)
+                fail(path, "does not start with a Vorbis identification header");
+            if(le32(packet + 7) != 0) fail(path, "Vorbis version %u", le32(packet + 7));
+            if(packet[11] != 2) fail(path, "%u channels, the mixer wants 2", packet[11]);
+            if(le32(packet + 12) != AUDIO_SAMPLE_RATE) fail(path, "%u Hz, output runs at %d Hz", le32(packet + 12), AUDIO_SAMPLE_RATE);
+        } else if(le32(page + 14) != serial) {
+            fail(path, "more than one logical stream; only one track is played");
+        }
+        ended = page[5] & 0x04;
+        at += pageSize;
+        pages++;
+    }
+    if(pages == 0) fail(path, "empty");
+    if(!ended) fail(path, "no end-of-stream page");
+
+    Asset* a = addAsset(name, PAK_VORBIS, path);
+    a->data = file;
+    a->entry.size = size;
+}
+
+static const char* meshNames[MESH_COUNT] = {
+    "cube white", "cube yellow", "cube blue", "player wings", "enemy basic",
+    "enemy zigzag", "enemy circler", "enemy shooter", "enemy tank", "enemy speedster"
+};
+
+static float absf(float v) { return v < 0 ? -v : v; }
+
+// A narrowed channel widened back to 8 bits the way the GE does it
+static int widen(unsigned int value, unsigned int levels) {
+    return (int)((value * 255 + levels / 2) / levels);
+}
+
+// Worst difference between any channel of an 8888 color and its 5650 or
+// 4444 form, in 8-bit steps. 5650 has no alpha; every mesh is opaque
+static int colorError(unsigned int color, int use4444) {
+    int channels[4] = {color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, color >> 24};
+    int back[4];
+    if(use4444) {
+        unsigned int c = meshColor4444(color);
+        for(int i = 0; i < 4; i++) back[i] = widen((c >> (4 * i)) & 0xF, 15);
+    } else {
+        unsigned int c = meshColor5650(color);
+        back[0] = widen(c & 0x1F, 31);
+        back[1] = widen((c >> 5) & 0x3F, 63);
+        back[2] = widen((c >> 11) & 0x1F, 31);
+        back[3] = 0xFF;
+    }
+    int worst = 0;
+    for(int i = 0; i < 4; i++) {
+        int d = abs(channels[i] - back[i]);
+        if(d > worst) worst = d;
+    }
+    return worst;
+}
+
+// Bake the meshes, pack them to 16-bit positions and 5650 colors, and report
+// how far the packed shapes are from the authored ones
+static void packMeshes(void) {
+    PakMeshTable table;
+    memset(&table, 0, sizeof(table));
+    struct Vertex vertices[MESH_VERTEX_CAPACITY];
+    struct PackedVertex packed[MESH_VERTEX_CAPACITY];
+    int count = meshBake(vertices, MESH_VERTEX_CAPACITY, table.ranges);
+    if(count < 0) fail("meshes", "more than MESH_VERTEX_CAPACITY (%d) vertices", MESH_VERTEX_CAPACITY);
+    if(meshPack(vertices, packed, count, MESH_POSITION_SCALE) > 0)
+        fail("meshes", "a shape reaches outside +-%.0f, the packed position range", MESH_POSITION_SCALE);
+
+    printf("%-16s %5s %10s %9s %9s\n", "mesh", "verts", "pos error", "5650 err", "4444 err");
+    float worstPosition = 0;
+    for(int id = 0; id < MESH_COUNT; id++) {
+        float position = 0;
+        int color5650 = 0, color4444 = 0;
+        for(int i = table.ranges[id].first; i < table.ranges[id].first + table.ranges[id].count; i++) {
+            const struct Vertex* v = &vertices[i];
+            const struct PackedVertex* p = &packed[i];
+            float error[3] = {absf(p->x * MESH_POSITION_SCALE / 32768.0f - v->x),
+                              absf(p->y * MESH_POSITION_SCALE / 32768.0f - v->y),
+                              absf(p->z * MESH_POSITION_SCALE / 32768.0f - v->z)};
+            for(int a = 0; a < 3; a++)
+                if(error[a] > position) position = error[a];
+            if((v->color >> 24) != 0xFF) fail("meshes", "%s is not opaque; 5650 colors have no alpha", meshNames[id]);
+            if(colorError(v->color, 0) > color5650) color5650 = colorError(v->color, 0);
+            if(colorError(v->color, 1) > color4444) color4444 = colorError(v->color, 1);
+        }
+        printf("%-16s %5d %10.6f %9d %9d\n", meshNames[id], table.ranges[id].count, position, color5650, color4444);
+        if(position > worstPosition) worstPosition = position;
+    }
+    printf("meshes: %d vertices, %u bytes packed (%u as floats), positions within %.6f\n",
+           count, (unsigned int)(count * sizeof(struct PackedVertex)), (unsigned int)(count * sizeof(struct Vertex)),
+           worstPosition);
+
+    table.meshCount = MESH_COUNT;
+    table.vertexCount = count;
+    table.verticesOffset = (sizeof(table) + 15) & ~15u;
+    table.positionScale = MESH_POSITION_SCALE;
+
+    Asset* a = addAsset(ASSET_MESHES, PAK_MESHES, "meshes");
+    a->entry.size = table.verticesOffset + count * sizeof(struct PackedVertex);
+    a->data = (unsigned char*)calloc(1, a->entry.size);
+    memcpy(a->data, &table, sizeof(table));
+    memcpy(a->data + table.verticesOffset, packed, count * sizeof(struct PackedVertex));
+}
+
+static unsigned int alignUp(unsigned int n, unsigned int to) {
+    return (n + to - 1) / to * to;
+}
+
+static void writeAt(FILE* f, const char* path, unsigned int offset, const void* data, unsigned int size) {
+    if(fseek(f, offset, SEEK_SET) != 0 || fwrite(data, 1, size, f) != size) fail(path, "write failed");
+}
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        fprintf(stderr, "usage: pack-assets OUTPUT NAME=FILE...\n");
+        return 1;
+    }
+
+    for(int i = 2; i < argc; i++) {
+        char name[PAK_NAME_LENGTH * 2];
+        const char* eq = strchr(argv[i], '=');
+        if(!eq || eq == argv[i] || eq - argv[i] >= (long)sizeof(name)) fail(argv[i], "expected NAME=FILE");
+        memcpy(name, argv[i], eq - argv[i]);
+        name[eq - argv[i]] = '\0';
+
+        const char* path = eq + 1;
+        const char* ext = strrchr(path, '.');
+        if(ext && strcmp(ext, ".wav") == 0) packWav(name, path);
+        else if(ext && strcmp(ext, ".ogg") == 0) packOgg(name, path);
+        else fail(path, "unknown asset type; expected .wav or .ogg");
+    }
+    packMeshes();
+
+    // Header and index, then resident assets, then streamed ones
+    unsigned int offset = alignUp(sizeof(PakHeader) + assetCount * sizeof(PakEntry), PAK_ALIGN);
+    for(int i = 0; i < assetCount; i++) {
+        if(assets[i].entry.type == PAK_VORBIS) continue;
+        assets[i].entry.offset = offset;
+        offset = alignUp(offset + assets[i].entry.size, PAK_ALIGN);
+    }
+    unsigned int residentBytes = offset;
+    for(int i = 0; i < assetCount; i++) {
+        if(assets[i].entry.type != PAK_VORBIS) continue;
+        offset = alignUp(offset, PAK_STREAM_ALIGN);
+        assets[i].entry.offset = offset;
+        offset += assets[i].entry.size;
+    }
+
+    const char* output = argv[1];
+    FILE* f = fopen(output, "wb");
+    if(!f) fail(output, "cannot create");
+    PakHeader header = {PAK_MAGIC, PAK_VERSION, assetCount, residentBytes};
+    writeAt(f, output, 0, &header, sizeof(header));
+    for(int i = 0; i < assetCount; i++) {
+        writeAt(f, output, sizeof(header) + i * sizeof(PakEntry), &assets[i].entry, sizeof(PakEntry));
+        writeAt(f, output, assets[i].entry.offset, assets[i].data, assets[i].entry.size);
+    }
+    // Pad the resident part out to its aligned size so it can be loaded whole
+    if(fseek(f, 0, SEEK_END) != 0 || ftell(f) < (long)residentBytes) {
+        unsigned char zero = 0;
+        writeAt(f, output, residentBytes - 1, &zero, 1);
+    }
+    if(fclose(f) != 0) fail(output, "write failed");
+
+    static const char* typeNames[] = {"", "pcm", "vorbis", "meshes"};
+    for(int i = 0; i < assetCount; i++) {
+        const PakEntry* e = &assets[i].entry;
+        printf("%-10s %-6s %8u bytes at %8u  %s\n", e->name, typeNames[e->type], e->size, e->offset, assets[i].source);
+    }
+    printf("%s: %d assets, %u bytes resident, %u total\n", output, assetCount, residentBytes, offset);
+    return 0;
+}